@@ -0,0 +1,104 @@
+#include <BlockScheduler.hpp>
+
+using namespace hyper;
+
+// distribute the blocks to the workers
+void BlockScheduler::Reset(const std::vector<Block> &blocks, unsigned worker_count) {
+
+    workers.clear();
+
+    if (0 == worker_count) {
+
+        worker_count = 1;
+
+    }
+
+    for (unsigned w = 0; w < worker_count; ++w) {
+
+        workers.emplace_back(new Worker());
+
+        // the contiguous run of the current worker
+        std::size_t begin = blocks.size() * w / worker_count;
+        std::size_t end = blocks.size() * (w + 1) / worker_count;
+
+        workers.back()->blocks.assign(blocks.begin() + begin, blocks.begin() + end);
+
+    }
+
+}
+
+// get the next block of a given worker
+bool BlockScheduler::Next(unsigned worker, Block &block) {
+
+    if (workers.size() <= worker) {
+
+        return false;
+
+    }
+
+    Worker &own(*workers[worker]);
+
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (!own.blocks.empty()) {
+
+            block = own.blocks.front();
+            own.blocks.pop_front();
+
+            return true;
+
+        }
+    }
+
+    return Steal(worker, block);
+
+}
+
+// take the block from the back of the busiest deque
+bool BlockScheduler::Steal(unsigned thief, Block &block) {
+
+    while (true) {
+
+        // find the busiest worker, the sizes can change meanwhile
+        unsigned victim = thief;
+        std::size_t largest = 0;
+
+        for (unsigned w = 0; w < workers.size(); ++w) {
+
+            if (thief != w) {
+
+                std::lock_guard<std::mutex> lock(workers[w]->mutex);
+
+                if (largest < workers[w]->blocks.size()) {
+
+                    largest = workers[w]->blocks.size();
+                    victim = w;
+
+                }
+
+            }
+
+        }
+
+        // nothing left, the blocks are never added back
+        if (0 == largest) {
+
+            return false;
+
+        }
+
+        std::lock_guard<std::mutex> lock(workers[victim]->mutex);
+
+        if (!workers[victim]->blocks.empty()) {
+
+            block = workers[victim]->blocks.back();
+            workers[victim]->blocks.pop_back();
+
+            return true;
+
+        }
+
+    }
+
+}
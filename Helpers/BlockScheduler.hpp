@@ -0,0 +1,53 @@
+#ifndef HYPERGRAPHSLAM_BLOCK_SCHEDULER_HPP
+#define HYPERGRAPHSLAM_BLOCK_SCHEDULER_HPP
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <vector>
+
+namespace hyper {
+
+// a work stealing scheduler of index ranges
+// each worker starts with a contiguous run of blocks and takes them from the front of its own deque
+// an idle worker steals from the back of the busiest deque, so the blocks far from the victim's current position go first
+class BlockScheduler {
+
+    public:
+
+        // an index range, the last index is shared with the next block
+        struct Block {
+
+            unsigned first, last;
+
+        };
+
+    private:
+
+        // the per worker deque
+        struct Worker {
+
+            std::mutex mutex;
+            std::deque<Block> blocks;
+
+        };
+
+        // the workers
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        // take the block from the back of the busiest deque
+        bool Steal(unsigned thief, Block &block);
+
+    public:
+
+        // distribute the blocks to the workers, in contiguous runs
+        void Reset(const std::vector<Block> &blocks, unsigned worker_count);
+
+        // get the next block of a given worker, it returns false when all the deques are empty
+        bool Next(unsigned worker, Block &block);
+
+};
+
+}
+
+#endif
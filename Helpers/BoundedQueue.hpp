@@ -0,0 +1,144 @@
+#ifndef HYPERGRAPHSLAM_BOUNDED_QUEUE_HPP
+#define HYPERGRAPHSLAM_BOUNDED_QUEUE_HPP
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace hyper {
+
+// a blocking FIFO queue with a maximum size, for producer/consumer pipelines
+template<typename T>
+class BoundedQueue {
+
+    private:
+
+        // the queued items
+        std::deque<T> items;
+
+        // the maximum number of queued items
+        std::size_t capacity;
+
+        // no more items after closing
+        bool closed;
+
+        // the queue mutex
+        std::mutex mutex;
+
+        // the producers and consumers wait here
+        std::condition_variable not_full, not_empty;
+
+        // removing the copy constructor
+        BoundedQueue(const BoundedQueue&) = delete;
+
+        // removing the assignment operator overloading
+        void operator=(const BoundedQueue&) = delete;
+
+    public:
+
+        // basic constructor
+        explicit BoundedQueue(std::size_t _capacity) : items(), capacity(0 < _capacity ? _capacity : 1), closed(false) {}
+
+        // push a new item, it blocks while the queue is full
+        // returns false if the queue was closed
+        bool Push(const T &item) {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            not_full.wait(lock, [this] { return closed || capacity > items.size(); });
+
+            if (closed) {
+
+                return false;
+
+            }
+
+            items.push_back(item);
+
+            not_empty.notify_one();
+
+            return true;
+
+        }
+
+        // push a new item only if there's room, it never blocks
+        // returns false if the queue is full or closed
+        bool TryPush(const T &item) {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            if (closed || capacity <= items.size()) {
+
+                return false;
+
+            }
+
+            items.push_back(item);
+
+            not_empty.notify_one();
+
+            return true;
+
+        }
+
+        // pop the next item, it blocks while the queue is empty
+        // returns false if the queue is closed and empty
+        bool Pop(T &item) {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            not_empty.wait(lock, [this] { return closed || !items.empty(); });
+
+            if (items.empty()) {
+
+                return false;
+
+            }
+
+            item = items.front();
+            items.pop_front();
+
+            not_full.notify_one();
+
+            return true;
+
+        }
+
+        // the consumers get the remaining items and then quit
+        void Close() {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            closed = true;
+
+            not_full.notify_all();
+            not_empty.notify_all();
+
+        }
+
+        // reopen an empty queue with a new maximum size
+        void Reset(std::size_t _capacity) {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            items.clear();
+
+            capacity = 0 < _capacity ? _capacity : 1;
+            closed = false;
+
+        }
+
+        // the current queue size
+        std::size_t Size() {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            return items.size();
+
+        }
+
+};
+
+}
+
+#endif
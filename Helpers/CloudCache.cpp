@@ -0,0 +1,304 @@
+#include <CloudCache.hpp>
+
+using namespace hyper;
+
+// basic constructor
+CloudCache::CloudCache() : entries(), lru(), budget(0), used(0), hits(0), misses(0), mutex() {}
+
+// remove the least recently used clouds without any handle
+void CloudCache::Evict() {
+
+    // start from the least recently used cloud
+    std::list<CloudKey>::iterator it = lru.end();
+
+    while (budget < used && lru.begin() != it) {
+
+        --it;
+
+        std::map<CloudKey, CacheEntry>::iterator entry = entries.find(*it);
+
+        // the pinned clouds stay in the cache
+        if (entry->second.pin.unique()) {
+
+            used -= entry->second.bytes;
+
+            entries.erase(entry);
+
+            it = lru.erase(it);
+
+        }
+
+    }
+
+}
+
+// a new pin of the cloud
+PointCloudHSV::ConstPtr CloudCache::Pin(const PointCloudHSV::ConstPtr &cloud) {
+
+    // the deleter only releases the captured cloud
+    return PointCloudHSV::ConstPtr(cloud.get(), [cloud](const PointCloudHSV*) {});
+
+}
+
+// set the memory budget in megabytes
+void CloudCache::SetBudget(unsigned megabytes) {
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    budget = std::size_t(megabytes) << 20;
+
+    Evict();
+
+}
+
+// get the cloud from the cache or load it with the given loader
+PointCloudHSV::ConstPtr CloudCache::Get(const PackedCloudStore &store, std::size_t slot, const CloudLoader &loader) {
+
+    CloudKey key(&store, slot);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        std::map<CloudKey, CacheEntry>::iterator entry = entries.find(key);
+
+        if (entries.end() != entry) {
+
+            // move it to the front
+            lru.splice(lru.begin(), lru, entry->second.lru);
+
+            ++hits;
+
+            return entry->second.pin;
+
+        }
+
+        ++misses;
+
+    }
+
+    // load the cloud outside the lock, so the other workers don't wait the loading
+    PointCloudHSV::Ptr cloud(new PointCloudHSV());
+
+    if (!loader(*cloud)) {
+
+        return PointCloudHSV::ConstPtr();
+
+    }
+
+    // the registration methods expect non dense clouds
+    cloud->is_dense = false;
+
+    if (0 == budget) {
+
+        return cloud;
+
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // another worker could have loaded the same cloud
+    std::map<CloudKey, CacheEntry>::iterator entry = entries.find(key);
+
+    if (entries.end() != entry) {
+
+        lru.splice(lru.begin(), lru, entry->second.lru);
+
+        return entry->second.pin;
+
+    }
+
+    // save the new cloud
+    lru.push_front(key);
+
+    CacheEntry &inserted(entries[key]);
+
+    inserted.cloud = cloud;
+    inserted.pin = Pin(cloud);
+    inserted.bytes = cloud->size() * sizeof(pcl::PointXYZHSV) + sizeof(PointCloudHSV);
+    inserted.lru = lru.begin();
+
+    used += inserted.bytes;
+
+    // the returned handle pins the new cloud
+    PointCloudHSV::ConstPtr handle(inserted.pin);
+
+    Evict();
+
+    return handle;
+
+}
+
+// get the registration features of a cloud returned by Get
+CloudFeatures::ConstPtr CloudCache::GetFeatures(const PackedCloudStore &store, std::size_t slot, const PointCloudHSV::ConstPtr &cloud) {
+
+    CloudKey key(&store, slot);
+
+    // the search tree keeps the cloud, so it gets the cache pointer instead of the handle
+    PointCloudHSV::ConstPtr source(cloud);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        std::map<CloudKey, CacheEntry>::iterator entry = entries.find(key);
+
+        if (entries.end() != entry && cloud == entry->second.cloud) {
+
+            if (nullptr != entry->second.features) {
+
+                return entry->second.features;
+
+            }
+
+            source = entry->second.cloud;
+
+        }
+
+    }
+
+    // build the features outside the lock
+    CloudFeatures::ConstPtr features(CloudFeatures::Build(source));
+
+    if (nullptr == features) {
+
+        return features;
+
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // the cloud could have been evicted or replaced
+    std::map<CloudKey, CacheEntry>::iterator entry = entries.find(key);
+
+    if (entries.end() != entry && cloud == entry->second.cloud) {
+
+        // another worker could have built the same features
+        if (nullptr != entry->second.features) {
+
+            return entry->second.features;
+
+        }
+
+        entry->second.features = features;
+
+        // the features are accounted with the cloud
+        entry->second.bytes += features->Bytes();
+        used += features->Bytes();
+
+        Evict();
+
+    }
+
+    return features;
+
+}
+
+// get a downsampled level of a cloud returned by Get and its features
+bool CloudCache::GetLevel(const PackedCloudStore &store, std::size_t slot, const PointCloudHSV::ConstPtr &cloud, double leaf, const CloudLoader &downsampler, PointCloudHSV::ConstPtr &coarse, CloudFeatures::ConstPtr &coarse_features) {
+
+    CloudKey key(&store, slot);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        std::map<CloudKey, CacheEntry>::iterator entry = entries.find(key);
+
+        if (entries.end() != entry && cloud == entry->second.cloud) {
+
+            std::map<double, CacheLevel>::iterator level = entry->second.levels.find(leaf);
+
+            if (entry->second.levels.end() != level) {
+
+                coarse = level->second.cloud;
+                coarse_features = level->second.features;
+
+                return true;
+
+            }
+
+        }
+
+    }
+
+    // downsample and build the features outside the lock
+    PointCloudHSV::Ptr filtered(new PointCloudHSV());
+
+    if (!downsampler(*filtered)) {
+
+        return false;
+
+    }
+
+    // the registration methods expect non dense clouds
+    filtered->is_dense = false;
+
+    coarse = filtered;
+    coarse_features = CloudFeatures::Build(filtered);
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // the cloud could have been evicted or replaced
+    std::map<CloudKey, CacheEntry>::iterator entry = entries.find(key);
+
+    if (entries.end() != entry && cloud == entry->second.cloud) {
+
+        std::map<double, CacheLevel>::iterator level = entry->second.levels.find(leaf);
+
+        // another worker could have built the same level
+        if (entry->second.levels.end() != level) {
+
+            coarse = level->second.cloud;
+            coarse_features = level->second.features;
+
+            return true;
+
+        }
+
+        CacheLevel &inserted(entry->second.levels[leaf]);
+
+        inserted.cloud = coarse;
+        inserted.features = coarse_features;
+
+        // the levels are accounted with the cloud
+        std::size_t bytes = filtered->size() * sizeof(pcl::PointXYZHSV) + sizeof(PointCloudHSV) + (nullptr != coarse_features ? coarse_features->Bytes() : 0);
+
+        entry->second.bytes += bytes;
+        used += bytes;
+
+        Evict();
+
+    }
+
+    return true;
+
+}
+
+// how many hits and misses
+void CloudCache::Statistics(std::size_t &_hits, std::size_t &_misses) {
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    _hits = hits;
+    _misses = misses;
+
+}
+
+// the used memory in bytes
+std::size_t CloudCache::Used() {
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    return used;
+
+}
+
+// remove all the clouds
+void CloudCache::Clear() {
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    entries.clear();
+    lru.clear();
+
+    used = hits = misses = 0;
+
+}
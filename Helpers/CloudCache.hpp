@@ -0,0 +1,127 @@
+#ifndef HYPERGRAPHSLAM_CLOUD_CACHE_HPP
+#define HYPERGRAPHSLAM_CLOUD_CACHE_HPP
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <utility>
+#include <functional>
+
+#include <PackedCloudStore.hpp>
+#include <CloudFeatures.hpp>
+
+namespace hyper {
+
+// a thread safe LRU cache of the filtered point clouds, with a memory budget
+// the returned clouds are shared and read only, a cloud can't be evicted while some handle is alive
+// the handles share their own reference count, so the search trees that keep the cloud don't pin it
+class CloudCache {
+
+    private:
+
+        // the cloud key, the store and the slot inside the store
+        typedef std::pair<const PackedCloudStore*, std::size_t> CloudKey;
+
+        // a downsampled level of a cached cloud, used by the coarse registration levels
+        struct CacheLevel {
+
+            // the downsampled cloud
+            PointCloudHSV::ConstPtr cloud;
+
+            // its registration features, null if the cloud is too small
+            CloudFeatures::ConstPtr features;
+
+        };
+
+        // the cached cloud
+        struct CacheEntry {
+
+            // the shared cloud, only the cache and the features keep this pointer
+            PointCloudHSV::ConstPtr cloud;
+
+            // the same cloud with a separate reference count, the handles are copies of it
+            // the cloud is pinned while some handle is alive
+            PointCloudHSV::ConstPtr pin;
+
+            // the registration features, built on demand
+            CloudFeatures::ConstPtr features;
+
+            // the downsampled levels and their features, built on demand, indexed by the leaf size
+            std::map<double, CacheLevel> levels;
+
+            // the cloud size in bytes
+            std::size_t bytes;
+
+            // the position inside the LRU list
+            std::list<CloudKey>::iterator lru;
+
+        };
+
+        // the cached clouds
+        std::map<CloudKey, CacheEntry> entries;
+
+        // the most recently used clouds are at the front
+        std::list<CloudKey> lru;
+
+        // the memory budget in bytes, zero disables the cache
+        std::size_t budget;
+
+        // the used memory in bytes
+        std::size_t used;
+
+        // the cache statistics
+        std::size_t hits, misses;
+
+        // the cache mutex
+        std::mutex mutex;
+
+        // remove the least recently used clouds without any handle, until the budget is respected
+        void Evict();
+
+        // a new pin of the cloud, it keeps the cloud alive after the eviction
+        static PointCloudHSV::ConstPtr Pin(const PointCloudHSV::ConstPtr &cloud);
+
+        // removing the copy constructor
+        CloudCache(const CloudCache&) = delete;
+
+        // removing the assignment operator overloading
+        void operator=(const CloudCache&) = delete;
+
+    public:
+
+        // basic constructor
+        CloudCache();
+
+        // set the memory budget in megabytes, zero disables the cache
+        void SetBudget(unsigned megabytes);
+
+        // the cloud loader, it expands the stored record to a pcl cloud
+        typedef std::function<bool(PointCloudHSV&)> CloudLoader;
+
+        // get the cloud from the cache or load it with the given loader
+        // returns a null pointer if the cloud can't be loaded
+        PointCloudHSV::ConstPtr Get(const PackedCloudStore &store, std::size_t slot, const CloudLoader &loader);
+
+        // get the registration features of a cloud returned by Get, they are built once while the cloud is cached
+        // returns a null pointer if the cloud is too small
+        CloudFeatures::ConstPtr GetFeatures(const PackedCloudStore &store, std::size_t slot, const PointCloudHSV::ConstPtr &cloud);
+
+        // get a downsampled level of a cloud returned by Get and its features, they are built once while the cloud is cached
+        // the downsampler fills the coarse cloud from the full resolution one, the features are null if the coarse cloud is too small
+        // returns false if the level can't be built
+        bool GetLevel(const PackedCloudStore &store, std::size_t slot, const PointCloudHSV::ConstPtr &cloud, double leaf, const CloudLoader &downsampler, PointCloudHSV::ConstPtr &coarse, CloudFeatures::ConstPtr &coarse_features);
+
+        // how many hits and misses
+        void Statistics(std::size_t &_hits, std::size_t &_misses);
+
+        // the used memory in bytes
+        std::size_t Used();
+
+        // remove all the clouds
+        void Clear();
+
+};
+
+}
+
+#endif
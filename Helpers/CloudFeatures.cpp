@@ -0,0 +1,96 @@
+#include <CloudFeatures.hpp>
+
+#include <Eigen/SVD>
+
+using namespace hyper;
+
+// build the features
+CloudFeatures::ConstPtr CloudFeatures::Build(const PointCloudHSV::ConstPtr &cloud) {
+
+    if (nullptr == cloud || CLOUD_FEATURES_NEIGHBORS > int(cloud->size())) {
+
+        return ConstPtr();
+
+    }
+
+    boost::shared_ptr<CloudFeatures> features(new CloudFeatures());
+
+    features->tree.reset(new SearchTree());
+    features->tree->setInputCloud(cloud);
+
+    features->covariances.reset(new Covariances(cloud->size()));
+
+    std::vector<int> indices;
+    std::vector<float> distances;
+
+    indices.reserve(CLOUD_FEATURES_NEIGHBORS);
+    distances.reserve(CLOUD_FEATURES_NEIGHBORS);
+
+    // the same covariance model of the pcl gicp
+    for (std::size_t i = 0; i < cloud->size(); ++i) {
+
+        Eigen::Matrix3d &cov((*features->covariances)[i]);
+        Eigen::Vector3d mean(Eigen::Vector3d::Zero());
+
+        cov.setZero();
+
+        features->tree->nearestKSearch(cloud->points[i], CLOUD_FEATURES_NEIGHBORS, indices, distances);
+
+        for (int j = 0; j < CLOUD_FEATURES_NEIGHBORS; ++j) {
+
+            const pcl::PointXYZHSV &p(cloud->points[indices[j]]);
+
+            mean[0] += p.x;
+            mean[1] += p.y;
+            mean[2] += p.z;
+
+            cov(0, 0) += p.x * p.x;
+            cov(1, 0) += p.y * p.x;
+            cov(1, 1) += p.y * p.y;
+            cov(2, 0) += p.z * p.x;
+            cov(2, 1) += p.z * p.y;
+            cov(2, 2) += p.z * p.z;
+
+        }
+
+        mean /= double(CLOUD_FEATURES_NEIGHBORS);
+
+        for (int k = 0; k < 3; ++k) {
+
+            for (int l = 0; l <= k; ++l) {
+
+                cov(k, l) /= double(CLOUD_FEATURES_NEIGHBORS);
+                cov(k, l) -= mean[k] * mean[l];
+                cov(l, k) = cov(k, l);
+
+            }
+
+        }
+
+        // the plane to plane model, unit variance along the surface and epsilon along the normal
+        Eigen::JacobiSVD<Eigen::Matrix3d> svd(cov, Eigen::ComputeFullU);
+        Eigen::Matrix3d U(svd.matrixU());
+
+        cov.setZero();
+
+        for (int k = 0; k < 3; ++k) {
+
+            Eigen::Vector3d col(U.col(k));
+
+            cov += (2 == k ? CLOUD_FEATURES_EPSILON : 1.0) * col * col.transpose();
+
+        }
+
+    }
+
+    return features;
+
+}
+
+// the approximate memory usage
+std::size_t CloudFeatures::Bytes() const {
+
+    // the tree keeps the coordinates and the indices of each point
+    return covariances->size() * (sizeof(Eigen::Matrix3d) + 3 * sizeof(float) + 2 * sizeof(int)) + sizeof(CloudFeatures);
+
+}
@@ -0,0 +1,52 @@
+#ifndef HYPERGRAPHSLAM_CLOUD_FEATURES_HPP
+#define HYPERGRAPHSLAM_CLOUD_FEATURES_HPP
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <pcl/search/kdtree.h>
+
+#include <PackedCloudStore.hpp>
+
+namespace hyper {
+
+// the gicp defaults
+#define CLOUD_FEATURES_NEIGHBORS 20
+#define CLOUD_FEATURES_EPSILON 0.001
+
+// the per cloud data that gicp would compute on every registration, the search tree and the point covariances
+// it's built once for each cached cloud and shared read only by all the registrations
+class CloudFeatures {
+
+    public:
+
+        // the search tree type
+        typedef pcl::search::KdTree<pcl::PointXYZHSV> SearchTree;
+
+        // the same covariances type used by gicp
+        typedef std::vector<Eigen::Matrix3d, Eigen::aligned_allocator<Eigen::Matrix3d>> Covariances;
+
+        // syntactic sugar
+        typedef boost::shared_ptr<const CloudFeatures> ConstPtr;
+
+        // the search tree over the cloud
+        SearchTree::Ptr tree;
+
+        // the point covariances, the same values gicp computes
+        boost::shared_ptr<Covariances> covariances;
+
+        // build the features, it returns a null pointer if the cloud is too small
+        static ConstPtr Build(const PointCloudHSV::ConstPtr &cloud);
+
+        // the approximate memory usage, in bytes
+        std::size_t Bytes() const;
+
+};
+
+}
+
+#endif
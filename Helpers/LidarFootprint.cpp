@@ -0,0 +1,146 @@
+#include <LidarFootprint.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+using namespace hyper;
+
+// basic constructor
+LidarFootprint::LidarFootprint() : bits(), count(0) {}
+
+// the grid side in cells
+int LidarFootprint::Side() {
+
+    return int(std::ceil(2.0 * LIDAR_FOOTPRINT_RADIUS / LIDAR_FOOTPRINT_RESOLUTION));
+
+}
+
+// the cell index of a position
+bool LidarFootprint::Cell(double x, double y, int &cx, int &cy) {
+
+    cx = int(std::floor((x + LIDAR_FOOTPRINT_RADIUS) / LIDAR_FOOTPRINT_RESOLUTION));
+    cy = int(std::floor((y + LIDAR_FOOTPRINT_RADIUS) / LIDAR_FOOTPRINT_RESOLUTION));
+
+    return 0 <= cx && Side() > cx && 0 <= cy && Side() > cy;
+
+}
+
+// is the cell occupied?
+bool LidarFootprint::Occupied(int cx, int cy) const {
+
+    if (bits.empty() || 0 > cx || Side() <= cx || 0 > cy || Side() <= cy) {
+
+        return false;
+
+    }
+
+    unsigned index = unsigned(cy * Side() + cx);
+
+    return 0 != (bits[index >> 6] & (uint64_t(1) << (index & 63)));
+
+}
+
+// build the footprint from the sensor cloud
+void LidarFootprint::Build(const pcl::PointCloud<pcl::PointXYZHSV> &cloud, bool tall_only) {
+
+    const unsigned cells = unsigned(Side() * Side());
+
+    bits.assign((cells + 63) / 64, 0);
+    count = 0;
+
+    for (const pcl::PointXYZHSV &p : cloud.points) {
+
+        int cx, cy;
+
+        if ((tall_only && LIDAR_FOOTPRINT_TALL_HUE != p.h) || !Cell(p.x, p.y, cx, cy)) {
+
+            continue;
+
+        }
+
+        unsigned index = unsigned(cy * Side() + cx);
+        uint64_t mask = uint64_t(1) << (index & 63);
+
+        if (0 == (bits[index >> 6] & mask)) {
+
+            bits[index >> 6] |= mask;
+            ++count;
+
+        }
+
+    }
+
+}
+
+// is there any structure?
+bool LidarFootprint::Empty() const {
+
+    return 0 == count;
+
+}
+
+// the fraction of the b structure that falls on the a structure
+double LidarFootprint::Overlap(const LidarFootprint &a, const LidarFootprint &b, double x, double y, double yaw) {
+
+    const double c = std::cos(yaw), s = std::sin(yaw);
+    const int side = Side();
+
+    // without structure, the b cells are the whole footprint
+    const bool area_only = a.Empty() || b.Empty();
+
+    unsigned total = 0, hits = 0;
+
+    for (int by = 0; by < side; ++by) {
+
+        for (int bx = 0; bx < side; ++bx) {
+
+            if (!area_only && !b.Occupied(bx, by)) {
+
+                continue;
+
+            }
+
+            ++total;
+
+            // the b cell center in the a frame
+            double px = (bx + 0.5) * LIDAR_FOOTPRINT_RESOLUTION - LIDAR_FOOTPRINT_RADIUS;
+            double py = (by + 0.5) * LIDAR_FOOTPRINT_RESOLUTION - LIDAR_FOOTPRINT_RADIUS;
+
+            int ax, ay;
+
+            if (!Cell(x + c * px - s * py, y + s * px + c * py, ax, ay)) {
+
+                continue;
+
+            }
+
+            if (area_only) {
+
+                ++hits;
+
+                continue;
+
+            }
+
+            // the dilated a cell
+            bool hit = false;
+
+            for (int dy = -1; dy <= 1 && !hit; ++dy) {
+
+                for (int dx = -1; dx <= 1 && !hit; ++dx) {
+
+                    hit = a.Occupied(ax + dx, ay + dy);
+
+                }
+
+            }
+
+            hits += hit;
+
+        }
+
+    }
+
+    return 0 < total ? double(hits) / double(total) : 0.0;
+
+}
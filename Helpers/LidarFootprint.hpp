@@ -0,0 +1,62 @@
+#ifndef HYPERGRAPHSLAM_LIDAR_FOOTPRINT_HPP
+#define HYPERGRAPHSLAM_LIDAR_FOOTPRINT_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+namespace hyper {
+
+// the footprint half size in meters, the far points are too sparse to matter in the registration
+#define LIDAR_FOOTPRINT_RADIUS 50.0
+
+// the cell size in meters
+#define LIDAR_FOOTPRINT_RESOLUTION 2.0
+
+// the hue of the tall points, painted by the lidar segmentation
+#define LIDAR_FOOTPRINT_TALL_HUE 96.0f
+
+// a range limited 2D occupancy bitmap of the structure seen by a scan, a few hundred bytes per scan
+// it estimates how much of a scan can be matched against another one, without loading the clouds
+class LidarFootprint {
+
+    private:
+
+        // the occupied cells, one bit each
+        std::vector<uint64_t> bits;
+
+        // how many occupied cells
+        unsigned count;
+
+        // the grid side in cells
+        static int Side();
+
+        // the cell index of a position, false when it's outside the footprint
+        static bool Cell(double x, double y, int &cx, int &cy);
+
+        // is the cell occupied? the outside cells are empty
+        bool Occupied(int cx, int cy) const;
+
+    public:
+
+        // basic constructor
+        LidarFootprint();
+
+        // build the footprint from the sensor cloud, only the segmentation tall points when tall_only is set
+        void Build(const pcl::PointCloud<pcl::PointXYZHSV> &cloud, bool tall_only);
+
+        // is there any structure?
+        bool Empty() const;
+
+        // the fraction of the b structure that falls on the a structure, from 0 to 1
+        // the motion (x, y, yaw) is the b frame wrt the a frame, the a cells are dilated by one cell to absorb the quantization
+        // without structure, it's the fraction of the b footprint area inside the a footprint
+        static double Overlap(const LidarFootprint &a, const LidarFootprint &b, double x, double y, double yaw);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include <LocalVoxelMap.hpp>
+
+#include <cmath>
+
+using namespace hyper;
+
+// basic constructor
+LocalVoxelMap::LocalVoxelMap(double _leaf, double _radius) :
+    leaf(0.0 < _leaf ? float(_leaf) : 1.0f),
+    radius(0.0 < _radius ? float(_radius) : 0.0f),
+    cloud(new PointCloudHSV()),
+    sums(),
+    voxels(),
+    pose(Eigen::Matrix4f::Identity()) {}
+
+// the voxel key
+int64_t LocalVoxelMap::Key(float x, float y, float z) const {
+
+    int64_t cx = int64_t(std::floor(x / leaf)) & 0x1fffff;
+    int64_t cy = int64_t(std::floor(y / leaf)) & 0x1fffff;
+    int64_t cz = int64_t(std::floor(z / leaf)) & 0x1fffff;
+
+    return (cx << 42) | (cy << 21) | cz;
+
+}
+
+// remove the voxels out of the radius
+void LocalVoxelMap::Evict() {
+
+    if (0.0f == radius) {
+
+        return;
+
+    }
+
+    float r2 = radius * radius;
+    float px = pose(0, 3), py = pose(1, 3);
+
+    unsigned i = 0;
+
+    while (i < sums.size()) {
+
+        const pcl::PointXYZHSV &p(cloud->points[i]);
+
+        float dx = p.x - px, dy = p.y - py;
+
+        if (r2 < dx * dx + dy * dy) {
+
+            voxels.erase(sums[i].key);
+
+            // move the last voxel to the current position
+            if (i + 1 < sums.size()) {
+
+                sums[i] = sums.back();
+                cloud->points[i] = cloud->points.back();
+
+                voxels[sums[i].key] = i;
+
+            }
+
+            sums.pop_back();
+            cloud->points.pop_back();
+
+        } else {
+
+            ++i;
+
+        }
+
+    }
+
+    cloud->width = cloud->points.size();
+    cloud->height = 1;
+
+}
+
+// remove all voxels and start a new map at the scan frame
+void LocalVoxelMap::Reset(const PointCloudHSV &scan) {
+
+    Clear();
+
+    Insert(scan, Eigen::Matrix4f::Identity());
+
+}
+
+// insert a new scan
+void LocalVoxelMap::Insert(const PointCloudHSV &scan, const Eigen::Matrix4f &scan_pose) {
+
+    for (const pcl::PointXYZHSV &p : scan.points) {
+
+        // the point in the map frame
+        Eigen::Vector4f q(scan_pose * Eigen::Vector4f(p.x, p.y, p.z, 1.0f));
+
+        int64_t key = Key(q[0], q[1], q[2]);
+
+        std::pair<std::unordered_map<int64_t, unsigned>::iterator, bool> inserted(voxels.emplace(key, sums.size()));
+
+        if (inserted.second) {
+
+            sums.push_back(VoxelSum { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0, key });
+            cloud->points.push_back(pcl::PointXYZHSV());
+
+        }
+
+        unsigned index = inserted.first->second;
+
+        VoxelSum &voxel(sums[index]);
+
+        voxel.x += q[0];
+        voxel.y += q[1];
+        voxel.z += q[2];
+        voxel.h += p.h;
+        voxel.s += p.s;
+        voxel.v += p.v;
+        ++voxel.count;
+
+        // the voxel centroid
+        pcl::PointXYZHSV &centroid(cloud->points[index]);
+
+        double inv = 1.0 / voxel.count;
+
+        centroid.x = float(voxel.x * inv);
+        centroid.y = float(voxel.y * inv);
+        centroid.z = float(voxel.z * inv);
+        centroid.h = float(voxel.h * inv);
+        centroid.s = float(voxel.s * inv);
+        centroid.v = float(voxel.v * inv);
+
+    }
+
+    pose = scan_pose;
+
+    Evict();
+
+    cloud->width = cloud->points.size();
+    cloud->height = 1;
+    cloud->is_dense = false;
+
+}
+
+// move the latest scan pose
+void LocalVoxelMap::SetPose(const Eigen::Matrix4f &_pose) {
+
+    pose = _pose;
+
+}
+
+// the latest scan pose in the map frame
+const Eigen::Matrix4f& LocalVoxelMap::Pose() const {
+
+    return pose;
+
+}
+
+// the map cloud
+PointCloudHSV::ConstPtr LocalVoxelMap::Cloud() const {
+
+    return cloud;
+
+}
+
+// remove all voxels
+void LocalVoxelMap::Clear() {
+
+    cloud->clear();
+    sums.clear();
+    voxels.clear();
+
+    pose.setIdentity();
+
+}
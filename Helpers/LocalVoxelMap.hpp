@@ -0,0 +1,82 @@
+#ifndef HYPERGRAPHSLAM_LOCAL_VOXEL_MAP_HPP
+#define HYPERGRAPHSLAM_LOCAL_VOXEL_MAP_HPP
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include <Eigen/Core>
+
+#include <PackedCloudStore.hpp>
+
+namespace hyper {
+
+// the accumulated local map of the sequential lidar registrations
+// the map keeps the frame of its first scan and each voxel holds the centroid of its points, like the voxel grid filter
+// the new scans are inserted in place and the voxels out of the radius are evicted, the existing map is never transformed or filtered again
+class LocalVoxelMap {
+
+    private:
+
+        // the voxel sums, in the same order as the cloud points
+        struct VoxelSum {
+
+            double x, y, z;
+            double h, s, v;
+            unsigned count;
+            int64_t key;
+
+        };
+
+        // the voxel side
+        float leaf;
+
+        // the eviction radius, zero keeps every voxel
+        float radius;
+
+        // the voxel centroids, it's the registration target
+        PointCloudHSV::Ptr cloud;
+
+        // the voxel sums
+        std::vector<VoxelSum> sums;
+
+        // the voxel hash, the values are the positions inside the cloud
+        std::unordered_map<int64_t, unsigned> voxels;
+
+        // the latest scan pose in the map frame
+        Eigen::Matrix4f pose;
+
+        // the voxel key
+        int64_t Key(float x, float y, float z) const;
+
+        // remove the voxels out of the radius around the latest scan
+        void Evict();
+
+    public:
+
+        // basic constructor
+        LocalVoxelMap(double _leaf, double _radius);
+
+        // remove all voxels and start a new map at the scan frame
+        void Reset(const PointCloudHSV &scan);
+
+        // insert a new scan, the pose is the scan frame inside the map frame
+        void Insert(const PointCloudHSV &scan, const Eigen::Matrix4f &scan_pose);
+
+        // move the latest scan pose without inserting anything, for the failed registrations
+        void SetPose(const Eigen::Matrix4f &_pose);
+
+        // the latest scan pose in the map frame
+        const Eigen::Matrix4f& Pose() const;
+
+        // the map cloud, it's updated in place by the next insertions
+        PointCloudHSV::ConstPtr Cloud() const;
+
+        // remove all voxels
+        void Clear();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef HYPERGRAPHSLAM_LOG_LINE_HPP
+#define HYPERGRAPHSLAM_LOG_LINE_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace hyper {
+
+// a non-owning view of a single carmen log line
+// the viewed buffer must outlive the view
+class LogLine {
+
+    public:
+
+        // the first char
+        const char *begin;
+
+        // one past the last char, the '\n' is not included
+        const char *end;
+
+        // basic constructor
+        LogLine() : begin(nullptr), end(nullptr) {}
+
+        // explicit constructor
+        LogLine(const char *_begin, const char *_end) : begin(_begin), end(_end) {}
+
+        // the line size in bytes
+        std::size_t size() const {
+
+            return std::size_t(end - begin);
+
+        }
+
+        // is it an empty view?
+        bool empty() const {
+
+            return end == begin;
+
+        }
+
+        // compare the viewed chars against a null terminated string, without any copy
+        bool Equals(const char *str) const {
+
+            std::size_t len = std::strlen(str);
+
+            return size() == len && 0 == std::memcmp(begin, str, len);
+
+        }
+
+        // split the line in the tag (the first word) and the remaining arguments
+        // the arguments view keeps the separator, just like the stream position after reading the tag
+        void SplitTag(LogLine &tag, LogLine &args) const {
+
+            // find the first separator
+            const char *space = static_cast<const char*>(std::memchr(begin, ' ', size()));
+
+            if (nullptr == space) {
+
+                space = end;
+
+            }
+
+            tag = LogLine(begin, space);
+            args = LogLine(space, end);
+
+        }
+
+        // copy the viewed chars, only when we really need an owning string
+        std::string ToString() const {
+
+            return std::string(begin, end);
+
+        }
+
+};
+
+}
+
+#endif
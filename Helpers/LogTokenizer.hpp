@@ -0,0 +1,375 @@
+#ifndef HYPERGRAPHSLAM_LOG_TOKENIZER_HPP
+#define HYPERGRAPHSLAM_LOG_TOKENIZER_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <LogLine.hpp>
+
+namespace hyper {
+
+// a cursor over a log line view, the tokens are separated by spaces
+// the numbers are parsed in place, without streams and without locale
+class LogTokenizer {
+
+    private:
+
+        // the current position
+        const char *cursor;
+
+        // one past the last char
+        const char *end;
+
+        // skip the separators
+        void SkipSpaces() {
+
+            while (end != cursor && (' ' == *cursor || '\t' == *cursor || '\r' == *cursor)) {
+
+                ++cursor;
+
+            }
+
+        }
+
+        // the exact powers of ten, the fast path only uses exponents up to 22
+        static double PowerOfTen(unsigned e) {
+
+            static const double powers[23] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+
+            return powers[e];
+
+        }
+
+        // the slow path, for long mantissas, big exponents, nan and inf
+        static double ParseDoubleFallback(const LogLine &token) {
+
+            // a null terminated copy
+            std::string str(token.ToString());
+
+            return std::strtod(str.c_str(), nullptr);
+
+        }
+
+        // parse a decimal integer, returns false if the token doesn't start with a digit after the optional sign
+        template<typename T>
+        bool ParseInteger(const LogLine &token, T &value) {
+
+            const char *c = token.begin;
+
+            bool negative = false;
+
+            if (token.end != c && ('-' == *c || '+' == *c)) {
+
+                negative = '-' == *c;
+
+                ++c;
+
+            }
+
+            // the first digit
+            const char *digits = c;
+
+            uint64_t accumulated = 0;
+
+            while (token.end != c) {
+
+                unsigned digit = unsigned(*c) - unsigned('0');
+
+                if (9 < digit) {
+
+                    break;
+
+                }
+
+                accumulated = accumulated * 10 + digit;
+
+                ++c;
+
+            }
+
+            // a bare sign or a token without leading digits, just like the stream extraction
+            if (digits == c) {
+
+                return false;
+
+            }
+
+            value = negative ? T(-int64_t(accumulated)) : T(accumulated);
+
+            return true;
+
+        }
+
+    public:
+
+        // basic constructor
+        explicit LogTokenizer(const LogLine &line) : cursor(line.begin), end(line.end) {}
+
+        // explicit constructor
+        LogTokenizer(const char *_begin, const char *_end) : cursor(_begin), end(_end) {}
+
+        // how many chars are left
+        std::size_t Remaining() const {
+
+            return std::size_t(end - cursor);
+
+        }
+
+        // get the next token view, returns false at the end of the line
+        bool Next(LogLine &token) {
+
+            SkipSpaces();
+
+            if (end == cursor) {
+
+                return false;
+
+            }
+
+            const char *begin = cursor;
+
+            while (end != cursor && ' ' != *cursor && '\t' != *cursor && '\r' != *cursor) {
+
+                ++cursor;
+
+            }
+
+            token = LogLine(begin, cursor);
+
+            return true;
+
+        }
+
+        // skip the next n tokens, without parsing them
+        void Skip(unsigned n) {
+
+            LogLine token;
+
+            while (0 < n && Next(token)) {
+
+                --n;
+
+            }
+
+        }
+
+        // the remaining chars, after the separators
+        LogLine Rest() {
+
+            SkipSpaces();
+
+            return LogLine(cursor, end);
+
+        }
+
+        // read a double value
+        bool Read(double &value) {
+
+            LogLine token;
+
+            if (!Next(token)) {
+
+                return false;
+
+            }
+
+            const char *c = token.begin;
+
+            bool negative = false;
+
+            if ('-' == *c || '+' == *c) {
+
+                negative = '-' == *c;
+
+                ++c;
+
+            }
+
+            // the decimal mantissa and the decimal exponent
+            uint64_t mantissa = 0;
+            int exponent = 0;
+            unsigned digits = 0;
+
+            // the integer part
+            while (token.end != c && unsigned(*c - '0') < 10) {
+
+                mantissa = mantissa * 10 + unsigned(*c - '0');
+
+                ++digits;
+                ++c;
+
+            }
+
+            // the fractional part
+            if (token.end != c && '.' == *c) {
+
+                ++c;
+
+                while (token.end != c && unsigned(*c - '0') < 10) {
+
+                    mantissa = mantissa * 10 + unsigned(*c - '0');
+
+                    --exponent;
+                    ++digits;
+                    ++c;
+
+                }
+
+            }
+
+            // the explicit exponent
+            if (token.end != c && ('e' == *c || 'E' == *c)) {
+
+                int e = 0;
+
+                LogLine exponent_token(c + 1, token.end);
+
+                if (!ParseInteger<int>(exponent_token, e)) {
+
+                    value = ParseDoubleFallback(token);
+
+                    return true;
+
+                }
+
+                exponent += e;
+                c = token.end;
+
+            }
+
+            // the mantissa must be exact in a double and the power of ten must be exact too
+            if (token.end != c || 0 == digits || 19 < digits || (uint64_t(1) << 53) < mantissa || 22 < std::abs(exponent)) {
+
+                value = ParseDoubleFallback(token);
+
+                return true;
+
+            }
+
+            value = double(mantissa);
+
+            if (0 > exponent) {
+
+                value /= PowerOfTen(unsigned(-exponent));
+
+            } else {
+
+                value *= PowerOfTen(unsigned(exponent));
+
+            }
+
+            if (negative) {
+
+                value = -value;
+
+            }
+
+            return true;
+
+        }
+
+        // read a float value
+        bool Read(float &value) {
+
+            double v = 0.0;
+
+            if (Read(v)) {
+
+                value = float(v);
+
+                return true;
+
+            }
+
+            return false;
+
+        }
+
+        // read an integer value
+        bool Read(int &value) {
+
+            LogLine token;
+
+            return Next(token) && ParseInteger<int>(token, value);
+
+        }
+
+        // read an unsigned value
+        bool Read(unsigned &value) {
+
+            LogLine token;
+
+            return Next(token) && ParseInteger<unsigned>(token, value);
+
+        }
+
+        // read an unsigned short value
+        bool Read(uint16_t &value) {
+
+            LogLine token;
+
+            return Next(token) && ParseInteger<uint16_t>(token, value);
+
+        }
+
+        // read a boolean value, stored as an integer
+        bool Read(bool &value) {
+
+            int v = 0;
+
+            if (Read(v)) {
+
+                value = 0 != v;
+
+                return true;
+
+            }
+
+            return false;
+
+        }
+
+        // read a single char
+        bool Read(char &value) {
+
+            SkipSpaces();
+
+            if (end == cursor) {
+
+                return false;
+
+            }
+
+            value = *cursor++;
+
+            return true;
+
+        }
+
+        // read a string, copying it
+        bool Read(std::string &value) {
+
+            LogLine token;
+
+            if (Next(token)) {
+
+                value.assign(token.begin, token.end);
+
+                return true;
+
+            }
+
+            return false;
+
+        }
+
+};
+
+}
+
+#endif
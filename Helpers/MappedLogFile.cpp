@@ -0,0 +1,177 @@
+#include <MappedLogFile.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace hyper;
+
+// basic constructor
+MappedLogFile::MappedLogFile() : fd(-1), data(nullptr), length(0), position(0) {}
+
+// basic destructor
+MappedLogFile::~MappedLogFile() {
+
+    Close();
+
+}
+
+// map the entire file to memory
+bool MappedLogFile::Open(const std::string &filename) {
+
+    // release any previous file
+    Close();
+
+    fd = open(filename.c_str(), O_RDONLY);
+
+    if (-1 == fd) {
+
+        return false;
+
+    }
+
+    // get the file size
+    struct stat info;
+
+    if (-1 == fstat(fd, &info) || !S_ISREG(info.st_mode)) {
+
+        Close();
+
+        return false;
+
+    }
+
+    length = std::size_t(info.st_size);
+
+    if (0 < length) {
+
+        void *region = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (MAP_FAILED == region) {
+
+            Close();
+
+            return false;
+
+        }
+
+        // the log is read from the beginning to the end
+        madvise(region, length, MADV_SEQUENTIAL);
+
+        data = static_cast<const char*>(region);
+
+    }
+
+    return true;
+
+}
+
+// unmap the file
+void MappedLogFile::Close() {
+
+    if (nullptr != data) {
+
+        munmap(const_cast<char*>(data), length);
+
+    }
+
+    if (-1 != fd) {
+
+        close(fd);
+
+    }
+
+    fd = -1;
+    data = nullptr;
+    length = 0;
+    position = 0;
+
+}
+
+// get the next line view
+bool MappedLogFile::ReadLine(LogLine &line) {
+
+    return ReadLine(line, position, length);
+
+}
+
+// get the next line view inside the given byte range
+bool MappedLogFile::ReadLine(LogLine &line, std::size_t &current, std::size_t last) const {
+
+    if (last <= current) {
+
+        return false;
+
+    }
+
+    // the line limits
+    const char *begin = data + current;
+    const char *newline = static_cast<const char*>(std::memchr(begin, '\n', last - current));
+    const char *end = nullptr != newline ? newline : data + last;
+
+    line = LogLine(begin, end);
+
+    // skip the '\n'
+    current = std::size_t(end - data) + 1;
+
+    return true;
+
+}
+
+// split the file in n byte ranges aligned to the line boundaries
+std::vector<std::size_t> MappedLogFile::SplitLines(unsigned n) const {
+
+    // the range limits
+    std::vector<std::size_t> limits(1, 0);
+
+    // the approximated range size
+    std::size_t step = 0 < n ? length / n : length;
+
+    for (unsigned i = 1; i < n; ++i) {
+
+        // the tentative limit
+        std::size_t limit = std::max(limits.back(), i * step);
+
+        if (length <= limit) {
+
+            break;
+
+        }
+
+        // move the limit to the beginning of the next line
+        const char *newline = static_cast<const char*>(std::memchr(data + limit, '\n', length - limit));
+
+        if (nullptr == newline) {
+
+            break;
+
+        }
+
+        limits.push_back(std::size_t(newline - data) + 1);
+
+    }
+
+    // the last range goes to the end of the file
+    limits.push_back(length);
+
+    return limits;
+
+}
+
+// the mapped region
+const char* MappedLogFile::Data() const {
+
+    return data;
+
+}
+
+// the file size
+std::size_t MappedLogFile::Size() const {
+
+    return length;
+
+}
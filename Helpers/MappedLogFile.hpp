@@ -0,0 +1,70 @@
+#ifndef HYPERGRAPHSLAM_MAPPED_LOG_FILE_HPP
+#define HYPERGRAPHSLAM_MAPPED_LOG_FILE_HPP
+
+#include <string>
+#include <vector>
+
+#include <LogLine.hpp>
+
+namespace hyper {
+
+// a read only memory mapped log file
+// the lines are returned as views of the mapped region, so nothing is copied
+class MappedLogFile {
+
+    private:
+
+        // the file descriptor
+        int fd;
+
+        // the mapped region
+        const char *data;
+
+        // the file size in bytes
+        std::size_t length;
+
+        // the next line position
+        std::size_t position;
+
+        // removing the copy constructor
+        MappedLogFile(const MappedLogFile&) = delete;
+
+        // removing the assignment operator overloading
+        void operator=(const MappedLogFile&) = delete;
+
+    public:
+
+        // basic constructor
+        MappedLogFile();
+
+        // basic destructor
+        ~MappedLogFile();
+
+        // map the entire file to memory, returns false if the file can't be mapped
+        bool Open(const std::string &filename);
+
+        // unmap the file
+        void Close();
+
+        // get the next line view, returns false at the end of the file
+        bool ReadLine(LogLine &line);
+
+        // get the next line view inside the [position, last) byte range, the position is updated
+        // it doesn't touch the internal position, so many threads can read the same file
+        bool ReadLine(LogLine &line, std::size_t &position, std::size_t last) const;
+
+        // split the file in n byte ranges aligned to the line boundaries
+        // it returns at most n + 1 range limits, the first one is zero and the last one is the file size
+        std::vector<std::size_t> SplitLines(unsigned n) const;
+
+        // the mapped region
+        const char* Data() const;
+
+        // the file size
+        std::size_t Size() const;
+
+};
+
+}
+
+#endif
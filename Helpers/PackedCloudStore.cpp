@@ -0,0 +1,302 @@
+#include <PackedCloudStore.hpp>
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+using namespace hyper;
+
+// the invalid slot definition
+const std::size_t PackedCloudStore::invalid_slot;
+
+// the record alignment definition
+const std::size_t PackedCloudStore::record_alignment;
+
+// the arena block size definition
+const std::size_t PackedCloudStore::arena_block_size;
+
+// basic constructor
+PackedCloudStore::PackedCloudStore() :
+    filename(""), fd(-1), entries(0), total_bytes(0), data(nullptr), mapped_size(0),
+    in_memory(false), sealed(false), blocks(0), block_used(0), block_capacity(0), mutex() {}
+
+// basic destructor
+PackedCloudStore::~PackedCloudStore() {
+
+    Close();
+
+}
+
+// create an empty data file
+bool PackedCloudStore::Open(const std::string &_filename) {
+
+    // release any previous file
+    Close();
+
+    fd = open(_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (-1 == fd) {
+
+        return false;
+
+    }
+
+    filename = _filename;
+
+    return true;
+
+}
+
+// create an empty in memory store
+void PackedCloudStore::OpenInMemory() {
+
+    // release any previous file
+    Close();
+
+    in_memory = true;
+
+}
+
+// append a raw record to the data file
+bool PackedCloudStore::Append(const char *buffer, std::size_t size, std::size_t &slot) {
+
+    // the byte position
+    std::size_t position;
+
+    // the arena address
+    char *address = nullptr;
+
+    // reserve the file or arena region and the slot, the writing happens outside the lock
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if ((-1 == fd && !in_memory) || sealed) {
+
+            return false;
+
+        }
+
+        if (in_memory) {
+
+            // the aligned position inside the last block
+            position = (block_used + record_alignment - 1) & ~(record_alignment - 1);
+
+            if (blocks.empty() || block_capacity < position + size) {
+
+                // a new block, the big records get their own block
+                block_capacity = std::max(arena_block_size, size);
+                blocks.push_back(std::unique_ptr<char[]>(new char[block_capacity]));
+
+                position = 0;
+
+            }
+
+            address = blocks.back().get() + position;
+            block_used = position + size;
+
+        } else {
+
+            // the aligned record position
+            position = (total_bytes + record_alignment - 1) & ~(record_alignment - 1);
+
+        }
+
+        slot = entries.size();
+
+        entries.push_back(CloudEntry { position, size, address });
+
+        total_bytes = in_memory ? total_bytes + size : position + size;
+
+    }
+
+    if (in_memory) {
+
+        // the arena blocks never move
+        std::memcpy(address, buffer, size);
+
+        return true;
+
+    }
+
+    // the disjoint regions can be written concurrently
+    while (0 < size) {
+
+        ssize_t written = pwrite(fd, buffer, size, off_t(position));
+
+        if (0 >= written) {
+
+            return false;
+
+        }
+
+        buffer += written;
+        position += std::size_t(written);
+        size -= std::size_t(written);
+
+    }
+
+    return true;
+
+}
+
+// append a cloud to the data file
+bool PackedCloudStore::Append(const PointCloudHSV &cloud, std::size_t &slot) {
+
+    return Append(reinterpret_cast<const char*>(cloud.points.data()), cloud.size() * sizeof(pcl::PointXYZHSV), slot);
+
+}
+
+// write the offset index and map the data file
+bool PackedCloudStore::Seal() {
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (-1 == fd && !in_memory) {
+
+        return false;
+
+    }
+
+    if (sealed || in_memory || 0 == total_bytes) {
+
+        sealed = true;
+
+        return true;
+
+    }
+
+    // the index file, for debugging and external tools
+    std::ofstream index(filename + ".index", std::ofstream::out);
+
+    if (index.is_open()) {
+
+        for (const CloudEntry &entry : entries) {
+
+            index << entry.offset << " " << entry.size << "\n";
+
+        }
+
+        index.close();
+
+    }
+
+    mapped_size = total_bytes;
+
+    void *region = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    if (MAP_FAILED == region) {
+
+        mapped_size = 0;
+
+        return false;
+
+    }
+
+    data = static_cast<const char*>(region);
+
+    sealed = true;
+
+    return true;
+
+}
+
+// get the raw record
+bool PackedCloudStore::Get(std::size_t slot, const char *&buffer, std::size_t &size) const {
+
+    if (entries.size() <= slot || (!in_memory && nullptr == data && 0 < total_bytes)) {
+
+        return false;
+
+    }
+
+    const CloudEntry &entry(entries[slot]);
+
+    buffer = in_memory ? entry.address : data + entry.offset;
+    size = entry.size;
+
+    return true;
+
+}
+
+// get the cloud points
+bool PackedCloudStore::Get(std::size_t slot, const pcl::PointXYZHSV *&points, std::size_t &count) const {
+
+    const char *buffer = nullptr;
+    std::size_t size = 0;
+
+    if (!Get(slot, buffer, size)) {
+
+        return false;
+
+    }
+
+    points = reinterpret_cast<const pcl::PointXYZHSV*>(buffer);
+    count = size / sizeof(pcl::PointXYZHSV);
+
+    return true;
+
+}
+
+// copy the cloud points to a pcl cloud
+bool PackedCloudStore::Load(std::size_t slot, PointCloudHSV &cloud) const {
+
+    const pcl::PointXYZHSV *points = nullptr;
+    std::size_t count = 0;
+
+    if (!Get(slot, points, count)) {
+
+        return false;
+
+    }
+
+    // a single copy, no parsing
+    cloud.points.assign(points, points + count);
+
+    cloud.width = uint32_t(count);
+    cloud.height = 1;
+    cloud.is_dense = true;
+
+    return true;
+
+}
+
+// how many clouds
+std::size_t PackedCloudStore::Size() const {
+
+    return entries.size();
+
+}
+
+// unmap and close the data file
+void PackedCloudStore::Close() {
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (nullptr != data) {
+
+        munmap(const_cast<char*>(data), mapped_size);
+
+    }
+
+    if (-1 != fd) {
+
+        close(fd);
+
+    }
+
+    filename.clear();
+    fd = -1;
+    entries.clear();
+    total_bytes = 0;
+    data = nullptr;
+    mapped_size = 0;
+    in_memory = false;
+    sealed = false;
+    blocks.clear();
+    block_used = block_capacity = 0;
+
+}
@@ -0,0 +1,134 @@
+#ifndef HYPERGRAPHSLAM_PACKED_CLOUD_STORE_HPP
+#define HYPERGRAPHSLAM_PACKED_CLOUD_STORE_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <limits>
+#include <memory>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+namespace hyper {
+
+// syntactic sugar
+typedef pcl::PointCloud<pcl::PointXYZHSV> PointCloudHSV;
+
+// an append only container with all the point clouds of a sensor
+// the clouds are packed in a single data file and the offset index is kept in memory
+// after sealing, the data file is mapped to memory and each cloud is just a pointer and a count
+// the records are raw pcl points or any other packed format, like the velodyne range images
+// the in memory mode keeps the records in a process local arena and never touches the filesystem
+class PackedCloudStore {
+
+    private:
+
+        // the record position inside the data file
+        struct CloudEntry {
+
+            // the first byte
+            std::size_t offset;
+
+            // the record size in bytes
+            std::size_t size;
+
+            // the record address, only in the in memory mode
+            const char *address;
+
+        };
+
+        // the records are aligned, so the mapped pcl points can be used directly
+        static const std::size_t record_alignment = 16;
+
+        // the arena block size, in bytes
+        static const std::size_t arena_block_size = 64 << 20;
+
+        // the data file name
+        std::string filename;
+
+        // the file descriptor
+        int fd;
+
+        // the offset index, the slots are assigned by the Append method
+        std::vector<CloudEntry> entries;
+
+        // how many bytes were appended
+        std::size_t total_bytes;
+
+        // the mapped region, only after sealing
+        const char *data;
+
+        // the mapped size in bytes
+        std::size_t mapped_size;
+
+        // keep the records in memory
+        bool in_memory;
+
+        // no more appends after sealing
+        bool sealed;
+
+        // the arena blocks, they never move
+        std::vector<std::unique_ptr<char[]>> blocks;
+
+        // the used and the total bytes of the last arena block
+        std::size_t block_used, block_capacity;
+
+        // the append mutex
+        std::mutex mutex;
+
+        // removing the copy constructor
+        PackedCloudStore(const PackedCloudStore&) = delete;
+
+        // removing the assignment operator overloading
+        void operator=(const PackedCloudStore&) = delete;
+
+    public:
+
+        // an invalid slot
+        static const std::size_t invalid_slot = std::numeric_limits<std::size_t>::max();
+
+        // basic constructor
+        PackedCloudStore();
+
+        // basic destructor
+        ~PackedCloudStore();
+
+        // create an empty data file, any previous content is discarded
+        bool Open(const std::string &_filename);
+
+        // create an empty in memory store, any previous content is discarded
+        void OpenInMemory();
+
+        // append a raw record to the data file, it's thread safe
+        // returns false if the record could not be written
+        bool Append(const char *buffer, std::size_t size, std::size_t &slot);
+
+        // append a cloud to the data file, it's thread safe
+        // returns false if the cloud could not be written
+        bool Append(const PointCloudHSV &cloud, std::size_t &slot);
+
+        // write the offset index next to the data file and map the data file for reading
+        // no clouds can be appended after sealing, the in memory stores are just marked as read only
+        bool Seal();
+
+        // get the raw record, only after sealing in the file mode
+        bool Get(std::size_t slot, const char *&buffer, std::size_t &size) const;
+
+        // get the cloud points, only after sealing
+        bool Get(std::size_t slot, const pcl::PointXYZHSV *&points, std::size_t &count) const;
+
+        // copy the cloud points to a pcl cloud, only after sealing
+        bool Load(std::size_t slot, PointCloudHSV &cloud) const;
+
+        // how many clouds
+        std::size_t Size() const;
+
+        // unmap and close the data file, or release the arena
+        void Close();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include <ScanContext.hpp>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+using namespace hyper;
+
+// build the descriptor from the sensor cloud
+void ScanContext::Build(const pcl::PointCloud<pcl::PointXYZHSV> &cloud) {
+
+    cells.assign(SCAN_CONTEXT_RINGS * SCAN_CONTEXT_SECTORS, 0);
+    ring_key.assign(SCAN_CONTEXT_RINGS, 0.0f);
+
+    const double ring_size = SCAN_CONTEXT_MAX_RADIUS / SCAN_CONTEXT_RINGS;
+    const double sector_size = 2.0 * M_PI / SCAN_CONTEXT_SECTORS;
+
+    for (const pcl::PointXYZHSV &p : cloud.points) {
+
+        double radius = std::sqrt(double(p.x) * p.x + double(p.y) * p.y);
+
+        if (SCAN_CONTEXT_MAX_RADIUS <= radius) {
+
+            continue;
+
+        }
+
+        unsigned ring = std::min(unsigned(radius / ring_size), unsigned(SCAN_CONTEXT_RINGS - 1));
+        unsigned sector = std::min(unsigned((std::atan2(double(p.y), double(p.x)) + M_PI) / sector_size), unsigned(SCAN_CONTEXT_SECTORS - 1));
+
+        // the quantized height, the empty cells are zeros
+        double height = std::max(1.0, std::min(255.0, (double(p.z) + SCAN_CONTEXT_HEIGHT_OFFSET) / SCAN_CONTEXT_HEIGHT_RESOLUTION));
+
+        uint8_t &cell(cells[ring * SCAN_CONTEXT_SECTORS + sector]);
+
+        cell = std::max(cell, uint8_t(height));
+
+    }
+
+    // the ring occupancy
+    for (unsigned ring = 0; ring < SCAN_CONTEXT_RINGS; ++ring) {
+
+        unsigned occupied = 0;
+
+        for (unsigned sector = 0; sector < SCAN_CONTEXT_SECTORS; ++sector) {
+
+            occupied += 0 < cells[ring * SCAN_CONTEXT_SECTORS + sector];
+
+        }
+
+        ring_key[ring] = float(occupied) / SCAN_CONTEXT_SECTORS;
+
+    }
+
+}
+
+// is there a descriptor?
+bool ScanContext::Empty() const {
+
+    return cells.empty();
+
+}
+
+// the ring key distance
+float ScanContext::RingKeyDistance(const ScanContext &a, const ScanContext &b) {
+
+    if (a.Empty() || b.Empty()) {
+
+        return std::numeric_limits<float>::max();
+
+    }
+
+    float distance = 0.0f;
+
+    for (unsigned ring = 0; ring < SCAN_CONTEXT_RINGS; ++ring) {
+
+        float diff = a.ring_key[ring] - b.ring_key[ring];
+
+        distance += diff * diff;
+
+    }
+
+    return std::sqrt(distance);
+
+}
+
+// the cosine distance between two sector columns
+bool ScanContext::ColumnDistance(const ScanContext &a, unsigned sa, const ScanContext &b, unsigned sb, float &distance) {
+
+    float dot = 0.0f, na = 0.0f, nb = 0.0f;
+
+    for (unsigned ring = 0; ring < SCAN_CONTEXT_RINGS; ++ring) {
+
+        float va = a.cells[ring * SCAN_CONTEXT_SECTORS + sa];
+        float vb = b.cells[ring * SCAN_CONTEXT_SECTORS + sb];
+
+        dot += va * vb;
+        na += va * va;
+        nb += vb * vb;
+
+    }
+
+    if (0.0f == na || 0.0f == nb) {
+
+        return false;
+
+    }
+
+    distance = 1.0f - dot / std::sqrt(na * nb);
+
+    return true;
+
+}
+
+// the column shifted distance
+float ScanContext::Distance(const ScanContext &a, const ScanContext &b, double &yaw) {
+
+    yaw = 0.0;
+
+    if (a.Empty() || b.Empty()) {
+
+        return 1.0f;
+
+    }
+
+    float best = 1.0f;
+
+    // the sector j of a matches the sector j - shift of b
+    for (unsigned shift = 0; shift < SCAN_CONTEXT_SECTORS; ++shift) {
+
+        float sum = 0.0f;
+        unsigned valid = 0;
+
+        for (unsigned sector = 0; sector < SCAN_CONTEXT_SECTORS; ++sector) {
+
+            float distance;
+
+            if (ColumnDistance(a, sector, b, (sector + SCAN_CONTEXT_SECTORS - shift) % SCAN_CONTEXT_SECTORS, distance)) {
+
+                sum += distance;
+                ++valid;
+
+            }
+
+        }
+
+        if (0 < valid && best > sum / valid) {
+
+            best = sum / valid;
+
+            // the b frame rotation, wrapped to [-pi, pi)
+            int signed_shift = SCAN_CONTEXT_SECTORS / 2 <= shift ? int(shift) - SCAN_CONTEXT_SECTORS : int(shift);
+
+            yaw = signed_shift * 2.0 * M_PI / SCAN_CONTEXT_SECTORS;
+
+        }
+
+    }
+
+    return best;
+
+}
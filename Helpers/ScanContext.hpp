@@ -0,0 +1,60 @@
+#ifndef HYPERGRAPHSLAM_SCAN_CONTEXT_HPP
+#define HYPERGRAPHSLAM_SCAN_CONTEXT_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+namespace hyper {
+
+// the polar grid
+#define SCAN_CONTEXT_RINGS 20
+#define SCAN_CONTEXT_SECTORS 60
+
+// the maximum radius in meters
+#define SCAN_CONTEXT_MAX_RADIUS 80.0
+
+// the height offset, the ground is close to -2.9 in the sensor frame
+#define SCAN_CONTEXT_HEIGHT_OFFSET 3.0
+
+// the height resolution in meters
+#define SCAN_CONTEXT_HEIGHT_RESOLUTION 0.05
+
+// a Scan Context global descriptor, the maximum height in each cell of a polar grid around the sensor
+// the heights are quantized to a byte, zero means an empty cell
+// the ring key is the rotation invariant occupancy of each ring, used to rank the candidates before the full comparison
+class ScanContext {
+
+    private:
+
+        // the quantized heights, ring major
+        std::vector<uint8_t> cells;
+
+        // the ring occupancy
+        std::vector<float> ring_key;
+
+        // the cosine distance between two sector columns, returns false if one of them is empty
+        static bool ColumnDistance(const ScanContext &a, unsigned sa, const ScanContext &b, unsigned sb, float &distance);
+
+    public:
+
+        // build the descriptor from the sensor cloud
+        void Build(const pcl::PointCloud<pcl::PointXYZHSV> &cloud);
+
+        // is there a descriptor?
+        bool Empty() const;
+
+        // the ring key distance, a cheap rotation invariant lower resolution comparison
+        static float RingKeyDistance(const ScanContext &a, const ScanContext &b);
+
+        // the column shifted distance, in [0, 1]
+        // the yaw is the rotation of the b frame wrt the a frame
+        static float Distance(const ScanContext &a, const ScanContext &b, double &yaw);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include <ScratchStorage.hpp>
+
+#include <iostream>
+
+#include <boost/filesystem/operations.hpp>
+
+using namespace hyper;
+
+// the scratch directory
+std::string ScratchStorage::root = SCRATCH_ROOT;
+
+// the storage mode
+bool ScratchStorage::in_memory = false;
+
+// set the scratch directory and the storage mode
+void ScratchStorage::Configure(const std::string &_root, bool _in_memory) {
+
+    root = _root;
+
+    // remove the trailing separators
+    while (1 < root.size() && '/' == root.back()) {
+
+        root.pop_back();
+
+    }
+
+    in_memory = _in_memory;
+
+}
+
+// the scratch directory
+const std::string& ScratchStorage::Root() {
+
+    return root;
+
+}
+
+// is it the in memory mode?
+bool ScratchStorage::InMemory() {
+
+    return in_memory;
+
+}
+
+// a path inside the scratch directory
+std::string ScratchStorage::Path(const std::string &relative) {
+
+    return root + "/" + relative;
+
+}
+
+// remove the previous scratch directory and create the empty tree
+bool ScratchStorage::Prepare() {
+
+    if (in_memory) {
+
+        std::cout << "Using the in memory scratch storage, no directories created." << std::endl;
+
+        return true;
+
+    }
+
+    // an empty or filesystem root scratch directory is a config mistake, never touch it
+    if (root.empty() || "/" == root) {
+
+        std::cerr << "Invalid scratch directory: '" << root << "'" << std::endl;
+
+        return false;
+
+    }
+
+    try {
+
+        if (boost::filesystem::exists(root)) {
+
+            if (!boost::filesystem::is_directory(root)) {
+
+                std::cerr << "The scratch directory " << root << " is not a directory" << std::endl;
+
+                return false;
+
+            }
+
+            // the same check after resolving the links and the dots
+            if (boost::filesystem::canonical(root) == boost::filesystem::canonical(root).root_path()) {
+
+                std::cerr << "Invalid scratch directory: '" << root << "'" << std::endl;
+
+                return false;
+
+            }
+
+        }
+
+        // remove only the subtrees owned by the parser, the root itself and anything else inside it are kept
+        for (const char *owned : { "sick", "velodyne", "lgm", "images" }) {
+
+            boost::filesystem::remove_all(Path(owned));
+
+        }
+
+        boost::filesystem::create_directories(root);
+        boost::filesystem::create_directory(Path("sick"));
+        boost::filesystem::create_directory(Path("velodyne"));
+        boost::filesystem::create_directory(Path("lgm"));
+        boost::filesystem::create_directory(Path("lgm/sick"));
+        boost::filesystem::create_directory(Path("lgm/velodyne"));
+        boost::filesystem::create_directory(Path("images"));
+
+    } catch (const boost::filesystem::filesystem_error &e) {
+
+        std::cerr << "Could not prepare the scratch directory " << root << ": " << e.what() << std::endl;
+
+        return false;
+
+    }
+
+    std::cout << "Necessary directories created in " << root << std::endl;
+
+    return true;
+
+}
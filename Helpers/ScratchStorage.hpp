@@ -0,0 +1,45 @@
+#ifndef HYPERGRAPHSLAM_SCRATCH_STORAGE_HPP
+#define HYPERGRAPHSLAM_SCRATCH_STORAGE_HPP
+
+#include <string>
+
+namespace hyper {
+
+// the default scratch directory
+#define SCRATCH_ROOT "/dados/tmp"
+
+// where the parser keeps the intermediate clouds and images
+// the in memory mode keeps everything in the process and never touches the filesystem
+class ScratchStorage {
+
+    private:
+
+        // the scratch directory
+        static std::string root;
+
+        // keep everything in memory
+        static bool in_memory;
+
+    public:
+
+        // set the scratch directory and the storage mode, before the parsing
+        static void Configure(const std::string &_root, bool _in_memory);
+
+        // the scratch directory
+        static const std::string& Root();
+
+        // is it the in memory mode?
+        static bool InMemory();
+
+        // a path inside the scratch directory
+        static std::string Path(const std::string &relative);
+
+        // remove the parser subtrees of the previous run and create the empty tree, nothing is done in the in memory mode
+        // it refuses an empty, filesystem root or non directory scratch path
+        static bool Prepare();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef HYPERGRAPHSLAM_SLAB_POOL_HPP
+#define HYPERGRAPHSLAM_SLAB_POOL_HPP
+
+#include <new>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <utility>
+
+namespace hyper {
+
+// the default number of objects per slab
+#define SLAB_POOL_SIZE 4096
+
+// a typed slab allocator, the objects of the same type are contiguous in memory
+// the slabs never move, so the pointers are stable until the pool is released
+// it's thread safe, the parser threads create objects concurrently
+template<typename T>
+class SlabPool {
+
+    private:
+
+        // the raw slabs
+        std::vector<T*> slabs;
+
+        // the alive flag of each constructed object, indexed by slab * slab_size + slot
+        std::vector<uint8_t> alive;
+
+        // how many objects per slab
+        std::size_t slab_size;
+
+        // how many slots were used in the last slab
+        std::size_t used;
+
+        // the pool mutex
+        std::mutex mutex;
+
+        // removing the copy constructor
+        SlabPool(const SlabPool&) = delete;
+
+        // removing the assignment operator overloading
+        void operator=(const SlabPool&) = delete;
+
+    public:
+
+        // basic constructor
+        explicit SlabPool(std::size_t _slab_size = SLAB_POOL_SIZE) :
+            slabs(0), alive(0), slab_size(0 < _slab_size ? _slab_size : 1), used(0), mutex() {}
+
+        // basic destructor
+        ~SlabPool() {
+
+            Release();
+
+        }
+
+        // build a new object inside the current slab
+        template<typename ...Args>
+        T* Create(Args&& ...args) {
+
+            // the reserved memory
+            T *address = nullptr;
+
+            // the reserved slot
+            std::size_t index = 0;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                if (slabs.empty() || slab_size == used) {
+
+                    // a new slab, the old ones never move
+                    slabs.push_back(static_cast<T*>(::operator new(slab_size * sizeof(T))));
+
+                    used = 0;
+
+                }
+
+                index = (slabs.size() - 1) * slab_size + used;
+                address = slabs.back() + used;
+
+                ++used;
+
+                alive.push_back(0);
+
+            }
+
+            // the constructor runs outside the lock
+            T *object = new (address) T(std::forward<Args>(args)...);
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            alive[index] = 1;
+
+            return object;
+
+        }
+
+        // destroy a single object, its memory is reused only after the release
+        void Destroy(T *object) {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            for (std::size_t i = 0; i < slabs.size(); ++i) {
+
+                if (slabs[i] <= object && slabs[i] + slab_size > object) {
+
+                    std::size_t index = i * slab_size + std::size_t(object - slabs[i]);
+
+                    if (alive[index]) {
+
+                        alive[index] = 0;
+
+                        object->~T();
+
+                    }
+
+                    return;
+
+                }
+
+            }
+
+        }
+
+        // destroy all the alive objects and release all the slabs at once
+        void Release() {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            for (std::size_t index = 0; index < alive.size(); ++index) {
+
+                if (alive[index]) {
+
+                    slabs[index / slab_size][index % slab_size].~T();
+
+                }
+
+            }
+
+            for (T *slab : slabs) {
+
+                ::operator delete(slab);
+
+            }
+
+            slabs.clear();
+            alive.clear();
+
+            used = 0;
+
+        }
+
+};
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include <SpatialGrid.hpp>
+
+#include <cmath>
+
+using namespace hyper;
+
+// basic constructor
+SpatialGrid::SpatialGrid(double _resolution) : resolution(0.0 < _resolution ? _resolution : 1.0), cells(), xs(), ys() {}
+
+// the cell key
+int64_t SpatialGrid::Key(int64_t cx, int64_t cy) {
+
+    return (cx << 32) ^ (cy & 0xffffffff);
+
+}
+
+// the cell coordinate
+int64_t SpatialGrid::Cell(double v) const {
+
+    return int64_t(std::floor(v / resolution));
+
+}
+
+// insert a new position
+void SpatialGrid::Insert(double x, double y, unsigned value) {
+
+    if (xs.size() <= value) {
+
+        xs.resize(value + 1);
+        ys.resize(value + 1);
+
+    }
+
+    xs[value] = x;
+    ys[value] = y;
+
+    cells[Key(Cell(x), Cell(y))].push_back(value);
+
+}
+
+// get all the values within the radius
+void SpatialGrid::Query(double x, double y, double radius, std::vector<unsigned> &output) const {
+
+    output.clear();
+
+    double r2 = radius * radius;
+
+    int64_t xmin = Cell(x - radius), xmax = Cell(x + radius);
+    int64_t ymin = Cell(y - radius), ymax = Cell(y + radius);
+
+    for (int64_t cx = xmin; cx <= xmax; ++cx) {
+
+        for (int64_t cy = ymin; cy <= ymax; ++cy) {
+
+            std::unordered_map<int64_t, std::vector<unsigned>>::const_iterator cell = cells.find(Key(cx, cy));
+
+            if (cells.end() == cell) {
+
+                continue;
+
+            }
+
+            for (unsigned value : cell->second) {
+
+                double dx = xs[value] - x;
+                double dy = ys[value] - y;
+
+                if (r2 > dx * dx + dy * dy) {
+
+                    output.push_back(value);
+
+                }
+
+            }
+
+        }
+
+    }
+
+}
+
+// the stored position
+double SpatialGrid::X(unsigned value) const {
+
+    return xs[value];
+
+}
+
+// the stored position
+double SpatialGrid::Y(unsigned value) const {
+
+    return ys[value];
+
+}
+
+// remove all positions
+void SpatialGrid::Clear() {
+
+    cells.clear();
+    xs.clear();
+    ys.clear();
+
+}
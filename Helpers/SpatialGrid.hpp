@@ -0,0 +1,53 @@
+#ifndef HYPERGRAPHSLAM_SPATIAL_GRID_HPP
+#define HYPERGRAPHSLAM_SPATIAL_GRID_HPP
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+namespace hyper {
+
+// a hashed 2D grid over the vehicle positions, for the radius queries
+// each position carries a value, usually the message position inside a list
+class SpatialGrid {
+
+    private:
+
+        // the cell side in meters
+        double resolution;
+
+        // the values inside each cell
+        std::unordered_map<int64_t, std::vector<unsigned>> cells;
+
+        // the stored positions, indexed by value
+        std::vector<double> xs, ys;
+
+        // the cell key
+        static int64_t Key(int64_t cx, int64_t cy);
+
+        // the cell coordinate
+        int64_t Cell(double v) const;
+
+    public:
+
+        // basic constructor, the resolution should be close to the query radius
+        explicit SpatialGrid(double _resolution);
+
+        // insert a new position, the values must be sequential starting from zero
+        void Insert(double x, double y, unsigned value);
+
+        // get all the values within the radius, in any order
+        void Query(double x, double y, double radius, std::vector<unsigned> &output) const;
+
+        // the stored position
+        double X(unsigned value) const;
+        double Y(unsigned value) const;
+
+        // remove all positions
+        void Clear();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+#include <TimeIndex.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+using namespace hyper;
+
+// append a new timestamp
+void TimeIndex::Push(double timestamp, unsigned value) {
+
+    timestamps.push_back(timestamp);
+    values.push_back(value);
+
+}
+
+// find the nearest timestamp
+bool TimeIndex::Nearest(double timestamp, unsigned &value, double &dt) const {
+
+    if (timestamps.empty()) {
+
+        return false;
+
+    }
+
+    // the first timestamp not before the query
+    std::size_t right = std::lower_bound(timestamps.begin(), timestamps.end(), timestamp) - timestamps.begin();
+
+    // the left neighbor is closer
+    if (timestamps.size() == right || (0 < right && timestamp - timestamps[right - 1] < timestamps[right] - timestamp)) {
+
+        --right;
+
+    }
+
+    value = values[right];
+    dt = std::fabs(timestamp - timestamps[right]);
+
+    return true;
+
+}
+
+// how many timestamps
+unsigned TimeIndex::Size() const {
+
+    return timestamps.size();
+
+}
+
+// remove all timestamps
+void TimeIndex::Clear() {
+
+    timestamps.clear();
+    values.clear();
+
+}
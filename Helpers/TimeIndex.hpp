@@ -0,0 +1,39 @@
+#ifndef HYPERGRAPHSLAM_TIME_INDEX_HPP
+#define HYPERGRAPHSLAM_TIME_INDEX_HPP
+
+#include <vector>
+
+namespace hyper {
+
+// the sorted timestamps of a single sensor stream, for the nearest in time lookups
+// each timestamp carries a value, usually the message position inside the stream
+class TimeIndex {
+
+    private:
+
+        // the sorted timestamps
+        std::vector<double> timestamps;
+
+        // the values, the same order of the timestamps
+        std::vector<unsigned> values;
+
+    public:
+
+        // append a new timestamp, the timestamps must be appended in time order
+        void Push(double timestamp, unsigned value);
+
+        // find the nearest timestamp, the later one wins the ties
+        // returns false if the index is empty
+        bool Nearest(double timestamp, unsigned &value, double &dt) const;
+
+        // how many timestamps
+        unsigned Size() const;
+
+        // remove all timestamps
+        void Clear();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,106 @@
+#include <VelodyneHexDecoder.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <tmmintrin.h>
+#endif
+
+using namespace hyper;
+
+// the portable version
+void VelodyneHexDecoder::DecodeColumnScalar(const char *column, uint16_t *ranges) {
+
+    for (unsigned j = 0; j < 32; ++j) {
+
+        // the current beam
+        const unsigned char *c = reinterpret_cast<const unsigned char*>(column + 6 * j);
+
+        // the hex char to nibble conversion without branches, '0' - '9', 'a' - 'f' and 'A' - 'F'
+        unsigned n0 = (c[0] & 0x0f) + 9 * (c[0] >> 6);
+        unsigned n1 = (c[1] & 0x0f) + 9 * (c[1] >> 6);
+        unsigned n2 = (c[2] & 0x0f) + 9 * (c[2] >> 6);
+        unsigned n3 = (c[3] & 0x0f) + 9 * (c[3] >> 6);
+
+        // the intensity chars are discarded
+        ranges[j] = uint16_t(n3 << 12 | n2 << 8 | n1 << 4 | n0);
+
+    }
+
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+// the SSSE3 version
+__attribute__((target("ssse3")))
+void VelodyneHexDecoder::DecodeColumnSSSE3(const char *column, uint16_t *ranges) {
+
+    // the hex char to nibble conversion constants
+    const __m128i low_mask = _mm_set1_epi8(0x0f);
+    const __m128i one = _mm_set1_epi8(1);
+
+    // each 48 chars hold 8 beams, the shuffles gather the 4 range nibbles of each beam
+    // the first output vector gets the beams 0 - 3, the second one gets the beams 4 - 7
+    const __m128i a_low = _mm_setr_epi8(0, 1, 2, 3, 6, 7, 8, 9, 12, 13, 14, 15, -1, -1, -1, -1);
+    const __m128i b_low = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 3, 4, 5);
+    const __m128i b_high = _mm_setr_epi8(8, 9, 10, 11, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i c_high = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 0, 1, 4, 5, 6, 7, 10, 11, 12, 13);
+
+    // the nibble pairs become bytes: even + 16 * odd
+    const __m128i pair_weights = _mm_setr_epi8(1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16);
+
+    for (unsigned i = 0; i < 4; ++i) {
+
+        const char *block = column + 48 * i;
+
+        // load the 48 chars
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32));
+
+        // the letter flags, (char >> 6) & 1
+        __m128i la = _mm_and_si128(_mm_srli_epi16(a, 6), one);
+        __m128i lb = _mm_and_si128(_mm_srli_epi16(b, 6), one);
+        __m128i lc = _mm_and_si128(_mm_srli_epi16(c, 6), one);
+
+        // nibble = (char & 0x0f) + 9 * flag, the flags are 0 or 1 so the shift doesn't cross the bytes
+        a = _mm_add_epi8(_mm_and_si128(a, low_mask), _mm_add_epi8(la, _mm_slli_epi16(la, 3)));
+        b = _mm_add_epi8(_mm_and_si128(b, low_mask), _mm_add_epi8(lb, _mm_slli_epi16(lb, 3)));
+        c = _mm_add_epi8(_mm_and_si128(c, low_mask), _mm_add_epi8(lc, _mm_slli_epi16(lc, 3)));
+
+        // gather the range nibbles, 4 beams per vector
+        __m128i low = _mm_or_si128(_mm_shuffle_epi8(a, a_low), _mm_shuffle_epi8(b, b_low));
+        __m128i high = _mm_or_si128(_mm_shuffle_epi8(b, b_high), _mm_shuffle_epi8(c, c_high));
+
+        // combine the nibble pairs, the results fit in the low byte of each 16 bits lane
+        low = _mm_maddubs_epi16(low, pair_weights);
+        high = _mm_maddubs_epi16(high, pair_weights);
+
+        // the byte pairs are the little endian 16 bits ranges
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ranges + 8 * i), _mm_packus_epi16(low, high));
+
+    }
+
+}
+
+#endif
+
+// decode the 32 raw ranges of a column
+void VelodyneHexDecoder::DecodeColumn(const char *column, uint16_t *ranges) {
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+    // check the cpu features only once
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+
+    if (has_ssse3) {
+
+        DecodeColumnSSSE3(column, ranges);
+
+        return;
+
+    }
+
+#endif
+
+    DecodeColumnScalar(column, ranges);
+
+}
@@ -0,0 +1,36 @@
+#ifndef HYPERGRAPHSLAM_VELODYNE_HEX_DECODER_HPP
+#define HYPERGRAPHSLAM_VELODYNE_HEX_DECODER_HPP
+
+#include <cstdint>
+
+namespace hyper {
+
+// each VELODYNE_PARTIAL_SCAN column has 32 beams encoded as 6 hex chars:
+// four range nibbles, the least significant first, and two intensity chars
+#define VELODYNE_HEX_COLUMN_SIZE 192
+
+class VelodyneHexDecoder {
+
+    private:
+
+        // the portable version
+        static void DecodeColumnScalar(const char *column, uint16_t *ranges);
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+        // the SSSE3 version, 8 beams per iteration
+        static void DecodeColumnSSSE3(const char *column, uint16_t *ranges);
+
+#endif
+
+    public:
+
+        // decode the 32 raw ranges of a column with VELODYNE_HEX_COLUMN_SIZE hex chars
+        // the SIMD version is selected at runtime, based on the cpu features
+        static void DecodeColumn(const char *column, uint16_t *ranges);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include <VelodyneRangeImage.hpp>
+
+#include <cstring>
+
+using namespace hyper;
+
+// the packed header: columns, range scale and the vertical angles flag
+static const std::size_t header_size = sizeof(uint32_t) + sizeof(float) + sizeof(uint32_t);
+
+// basic constructor
+VelodyneRangeImage::VelodyneRangeImage() : range_scale(0.0f), from_log(false), azimuth(0), ranges(0), labels(0) {}
+
+// resize the image
+void VelodyneRangeImage::Resize(unsigned columns) {
+
+    azimuth.assign(columns, 0.0f);
+    ranges.assign(32 * columns, 0);
+    labels.assign(32 * columns, RANGE_IMAGE_EMPTY);
+
+}
+
+// how many columns
+unsigned VelodyneRangeImage::Columns() const {
+
+    return unsigned(azimuth.size());
+
+}
+
+// the packed size in bytes
+std::size_t VelodyneRangeImage::PackedSize() const {
+
+    return header_size + azimuth.size() * sizeof(float) + ranges.size() * sizeof(uint16_t) + labels.size() * sizeof(uint8_t);
+
+}
+
+// write the packed image
+void VelodyneRangeImage::Pack(char *buffer) const {
+
+    // the header
+    uint32_t columns = Columns();
+    uint32_t flags = from_log ? 1 : 0;
+
+    std::memcpy(buffer, &columns, sizeof(uint32_t));
+    buffer += sizeof(uint32_t);
+
+    std::memcpy(buffer, &range_scale, sizeof(float));
+    buffer += sizeof(float);
+
+    std::memcpy(buffer, &flags, sizeof(uint32_t));
+    buffer += sizeof(uint32_t);
+
+    // the azimuth column
+    std::memcpy(buffer, azimuth.data(), azimuth.size() * sizeof(float));
+    buffer += azimuth.size() * sizeof(float);
+
+    // the ranges
+    std::memcpy(buffer, ranges.data(), ranges.size() * sizeof(uint16_t));
+    buffer += ranges.size() * sizeof(uint16_t);
+
+    // the labels
+    std::memcpy(buffer, labels.data(), labels.size() * sizeof(uint8_t));
+
+}
+
+// read a packed image
+bool VelodyneRangeImage::Unpack(const char *buffer, std::size_t size) {
+
+    if (header_size > size) {
+
+        return false;
+
+    }
+
+    // the header
+    uint32_t columns = 0, flags = 0;
+
+    std::memcpy(&columns, buffer, sizeof(uint32_t));
+    buffer += sizeof(uint32_t);
+
+    std::memcpy(&range_scale, buffer, sizeof(float));
+    buffer += sizeof(float);
+
+    std::memcpy(&flags, buffer, sizeof(uint32_t));
+    buffer += sizeof(uint32_t);
+
+    from_log = 0 != flags;
+
+    // each column has the azimuth, 32 ranges and 32 labels
+    if (header_size + std::size_t(columns) * (sizeof(float) + 32 * (sizeof(uint16_t) + sizeof(uint8_t))) != size) {
+
+        return false;
+
+    }
+
+    Resize(columns);
+
+    // the azimuth column
+    std::memcpy(azimuth.data(), buffer, azimuth.size() * sizeof(float));
+    buffer += azimuth.size() * sizeof(float);
+
+    // the ranges
+    std::memcpy(ranges.data(), buffer, ranges.size() * sizeof(uint16_t));
+    buffer += ranges.size() * sizeof(uint16_t);
+
+    // the labels
+    std::memcpy(labels.data(), buffer, labels.size() * sizeof(uint8_t));
+
+    return true;
+
+}
@@ -0,0 +1,58 @@
+#ifndef HYPERGRAPHSLAM_VELODYNE_RANGE_IMAGE_HPP
+#define HYPERGRAPHSLAM_VELODYNE_RANGE_IMAGE_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace hyper {
+
+// the range image cell labels, from the lidar segmentation
+#define RANGE_IMAGE_EMPTY 0
+#define RANGE_IMAGE_TALL 1
+#define RANGE_IMAGE_GROUND 2
+
+// a 32 x N velodyne scan, one column per azimuth
+// each cell keeps the raw 16 bits range and the segmentation label, so a point needs 3 bytes instead of a pcl::PointXYZHSV
+// the cartesian coordinates are computed only when the registration needs the cloud
+class VelodyneRangeImage {
+
+    public:
+
+        // the raw range unit, in meters
+        float range_scale;
+
+        // the in-log scans use the complementary vertical angles
+        bool from_log;
+
+        // the column azimuths, in radians
+        std::vector<float> azimuth;
+
+        // the raw ranges, 32 cells per column
+        std::vector<uint16_t> ranges;
+
+        // the cell labels, 32 cells per column
+        std::vector<uint8_t> labels;
+
+        // basic constructor
+        VelodyneRangeImage();
+
+        // resize the image, all cells are empty
+        void Resize(unsigned columns);
+
+        // how many columns
+        unsigned Columns() const;
+
+        // the packed size in bytes
+        std::size_t PackedSize() const;
+
+        // write the packed image to a buffer with PackedSize bytes
+        void Pack(char *buffer) const;
+
+        // read a packed image, returns false if the buffer is not a valid image
+        bool Unpack(const char *buffer, std::size_t size);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,521 @@
+#include <VoxelizedGICP.hpp>
+
+#include <cmath>
+#include <limits>
+
+#include <Eigen/SVD>
+#include <Eigen/Geometry>
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
+
+using namespace hyper;
+
+// the jacobian wrt the left perturbation [rotation, translation]
+static inline void Jacobian(const Eigen::Vector4f &p, const Eigen::Matrix3f &, Eigen::Matrix<float, 3, 6> &J) {
+
+    J << 0.0f, -p[2], p[1], -1.0f, 0.0f, 0.0f,
+         p[2], 0.0f, -p[0], 0.0f, -1.0f, 0.0f,
+         -p[1], p[0], 0.0f, 0.0f, 0.0f, -1.0f;
+
+}
+
+// the jacobian wrt the left perturbation [yaw, x, y] in the leveled target frame
+static inline void Jacobian(const Eigen::Vector4f &p, const Eigen::Matrix3f &leveling, Eigen::Matrix<float, 3, 3> &J) {
+
+    // the leveled point
+    Eigen::Vector3f q(leveling * p.head<3>());
+
+    Eigen::Matrix3f Jq;
+    Jq << q[1], -1.0f, 0.0f,
+          -q[0], 0.0f, -1.0f,
+          0.0f, 0.0f, 0.0f;
+
+    // back to the target frame
+    J = leveling.transpose() * Jq;
+
+}
+
+// the homogeneous version of a rotation
+static inline Eigen::Matrix4f Homogeneous(const Eigen::Matrix3f &R) {
+
+    Eigen::Matrix4f T(Eigen::Matrix4f::Identity());
+    T.block<3, 3>(0, 0) = R;
+
+    return T;
+
+}
+
+// basic constructor
+VoxelizedGICP::VoxelizedGICP() :
+    resolution(VGICP_RESOLUTION),
+    threads(1),
+    max_iterations(VGICP_MAX_ITERATIONS),
+    epsilon(VGICP_TRANSFORMATION_EPSILON),
+    planar(false),
+    ground_leveling(false),
+    source_leveling(Eigen::Matrix3f::Identity()),
+    target_leveling(Eigen::Matrix3f::Identity()),
+    source_points(),
+    source_covariances(),
+    voxels(),
+    voxel_means(),
+    voxel_covariances(),
+    transformation(Eigen::Matrix4f::Identity()),
+    converged(false),
+    fitness(std::numeric_limits<double>::max()) {}
+
+// the voxel key
+int64_t VoxelizedGICP::Key(const Eigen::Vector4f &p) const {
+
+    int64_t x = int64_t(std::floor(p[0] / resolution)) & 0x1fffff;
+    int64_t y = int64_t(std::floor(p[1] / resolution)) & 0x1fffff;
+    int64_t z = int64_t(std::floor(p[2] / resolution)) & 0x1fffff;
+
+    return (x << 42) | (y << 21) | z;
+
+}
+
+// keep only the surface shape
+Eigen::Matrix4f VoxelizedGICP::Regularize(const Eigen::Matrix3d &covariance) {
+
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd(covariance, Eigen::ComputeFullU);
+    Eigen::Matrix3d U(svd.matrixU());
+
+    Eigen::Matrix3d regularized(U * Eigen::Vector3d(1.0, 1.0, CLOUD_FEATURES_EPSILON).asDiagonal() * U.transpose());
+
+    Eigen::Matrix4f padded(Eigen::Matrix4f::Zero());
+    padded.block<3, 3>(0, 0) = regularized.cast<float>();
+
+    return padded;
+
+}
+
+// the rotation that aligns the ground normal with the z axis
+Eigen::Matrix3f VoxelizedGICP::GroundLeveling(const PointCloudHSV &cloud) {
+
+    Eigen::Vector3d sum(Eigen::Vector3d::Zero());
+    Eigen::Matrix3d second(Eigen::Matrix3d::Zero());
+    unsigned count = 0;
+
+    for (const pcl::PointXYZHSV &p : cloud.points) {
+
+        // only the segmentation ground points, the voxel filter can mix the colors
+        if (1.0f > std::fabs(p.h - VGICP_GROUND_HUE)) {
+
+            Eigen::Vector3d point(p.x, p.y, p.z);
+
+            sum += point;
+            second += point * point.transpose();
+            ++count;
+
+        }
+
+    }
+
+    if (VGICP_MIN_GROUND_POINTS > count) {
+
+        return Eigen::Matrix3f::Identity();
+
+    }
+
+    Eigen::Vector3d mean(sum / count);
+
+    // the normal is the smallest eigenvector
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(second / count - mean * mean.transpose());
+    Eigen::Vector3d normal(solver.eigenvectors().col(0));
+
+    if (0.0 > normal[2]) {
+
+        normal = -normal;
+
+    }
+
+    if (VGICP_MAX_GROUND_TILT < std::acos(std::min(1.0, normal[2]))) {
+
+        return Eigen::Matrix3f::Identity();
+
+    }
+
+    return Eigen::Quaterniond::FromTwoVectors(normal, Eigen::Vector3d::UnitZ()).toRotationMatrix().cast<float>();
+
+}
+
+// set the voxel size
+void VoxelizedGICP::SetResolution(double _resolution) {
+
+    resolution = 0.0 < _resolution ? float(_resolution) : float(VGICP_RESOLUTION);
+
+}
+
+// set how many threads inside a single alignment
+void VoxelizedGICP::SetThreads(unsigned _threads) {
+
+    threads = 0 < _threads ? _threads : 1;
+
+}
+
+// set the maximum gauss newton iterations
+void VoxelizedGICP::SetMaxIterations(unsigned _max_iterations) {
+
+    max_iterations = 0 < _max_iterations ? _max_iterations : 1;
+
+}
+
+// optimize only x, y and yaw
+void VoxelizedGICP::SetPlanar(bool _planar) {
+
+    planar = _planar;
+
+}
+
+// is it the planar mode?
+bool VoxelizedGICP::IsPlanar() const {
+
+    return planar;
+
+}
+
+// fit the ground planes of the next clouds
+void VoxelizedGICP::SetGroundLeveling(bool _ground_leveling) {
+
+    ground_leveling = _ground_leveling;
+
+}
+
+// set the source cloud and its point covariances
+bool VoxelizedGICP::SetSource(const PointCloudHSV &cloud, const CloudFeatures::Covariances &covariances) {
+
+    if (cloud.size() != covariances.size()) {
+
+        return false;
+
+    }
+
+    source_leveling = planar && ground_leveling ? GroundLeveling(cloud) : Eigen::Matrix3f::Identity();
+
+    source_points.resize(cloud.size());
+    source_covariances.resize(cloud.size());
+
+    for (std::size_t i = 0; i < cloud.size(); ++i) {
+
+        const pcl::PointXYZHSV &p(cloud.points[i]);
+
+        source_points[i] = Eigen::Vector4f(p.x, p.y, p.z, 1.0f);
+
+        source_covariances[i].setZero();
+        source_covariances[i].block<3, 3>(0, 0) = covariances[i].cast<float>();
+
+    }
+
+    return !source_points.empty();
+
+}
+
+// build the target voxels
+bool VoxelizedGICP::SetTarget(const PointCloudHSV &cloud, const CloudFeatures::Covariances *covariances) {
+
+    if (nullptr != covariances && cloud.size() != covariances->size()) {
+
+        return false;
+
+    }
+
+    target_leveling = planar && ground_leveling ? GroundLeveling(cloud) : Eigen::Matrix3f::Identity();
+
+    // the voxel sums
+    struct VoxelSum {
+
+        Eigen::Vector3d sum;
+        Eigen::Matrix3d second;
+        unsigned count;
+
+    };
+
+    std::unordered_map<int64_t, unsigned> sums_index;
+    std::vector<VoxelSum, Eigen::aligned_allocator<VoxelSum>> sums;
+
+    for (std::size_t i = 0; i < cloud.size(); ++i) {
+
+        const pcl::PointXYZHSV &p(cloud.points[i]);
+
+        Eigen::Vector3d point(p.x, p.y, p.z);
+
+        std::pair<std::unordered_map<int64_t, unsigned>::iterator, bool> inserted(sums_index.emplace(Key(Eigen::Vector4f(p.x, p.y, p.z, 1.0f)), sums.size()));
+
+        if (inserted.second) {
+
+            sums.push_back(VoxelSum { Eigen::Vector3d::Zero(), Eigen::Matrix3d::Zero(), 0 });
+
+        }
+
+        VoxelSum &voxel(sums[inserted.first->second]);
+
+        voxel.sum += point;
+        voxel.second += nullptr != covariances ? (*covariances)[i] : Eigen::Matrix3d(point * point.transpose());
+        ++voxel.count;
+
+    }
+
+    voxels.clear();
+    voxel_means.clear();
+    voxel_covariances.clear();
+
+    for (const std::pair<const int64_t, unsigned> &entry : sums_index) {
+
+        const VoxelSum &voxel(sums[entry.second]);
+
+        Eigen::Vector3d mean(voxel.sum / voxel.count);
+        Eigen::Matrix4f covariance(Eigen::Matrix4f::Zero());
+
+        if (nullptr != covariances) {
+
+            // the mean of the point covariances
+            covariance.block<3, 3>(0, 0) = (voxel.second / voxel.count).cast<float>();
+
+        } else if (VGICP_MIN_VOXEL_POINTS <= voxel.count) {
+
+            // the voxel points covariance
+            covariance = Regularize(voxel.second / voxel.count - mean * mean.transpose());
+
+        } else {
+
+            continue;
+
+        }
+
+        voxels.emplace(entry.first, voxel_means.size());
+        voxel_means.push_back(Eigen::Vector4f(mean[0], mean[1], mean[2], 1.0f));
+        voxel_covariances.push_back(covariance);
+
+    }
+
+    return !voxels.empty();
+
+}
+
+// accumulate the gauss newton system
+template<int DOF>
+std::size_t VoxelizedGICP::Linearize(const Eigen::Matrix4f &T, Eigen::Matrix<double, DOF, DOF> &H, Eigen::Matrix<double, DOF, 1> &b, double &error) const {
+
+    H.setZero();
+    b.setZero();
+    error = 0.0;
+
+    std::size_t matched = 0;
+
+    // the rotation part, padded
+    Eigen::Matrix4f R(Eigen::Matrix4f::Zero());
+    R.block<3, 3>(0, 0) = T.block<3, 3>(0, 0);
+
+    const long size = long(source_points.size());
+
+    #pragma omp parallel num_threads(threads)
+    {
+        // the thread local system
+        Eigen::Matrix<double, DOF, DOF> local_H(Eigen::Matrix<double, DOF, DOF>::Zero());
+        Eigen::Matrix<double, DOF, 1> local_b(Eigen::Matrix<double, DOF, 1>::Zero());
+        double local_error = 0.0;
+        std::size_t local_matched = 0;
+
+        #pragma omp for nowait
+        for (long i = 0; i < size; ++i) {
+
+            // the transformed source point
+            Eigen::Vector4f p(T * source_points[i]);
+
+            std::unordered_map<int64_t, unsigned>::const_iterator voxel = voxels.find(Key(p));
+
+            if (voxels.end() == voxel) {
+
+                continue;
+
+            }
+
+            // the residual, the last coordinate is zero
+            Eigen::Vector4f e(voxel_means[voxel->second] - p);
+
+            // the combined covariance
+            Eigen::Matrix4f C(voxel_covariances[voxel->second] + R * source_covariances[i] * R.transpose());
+
+            Eigen::Matrix3f M(C.block<3, 3>(0, 0).inverse());
+
+            // the jacobian wrt the left perturbation
+            Eigen::Matrix<float, 3, DOF> J;
+            Jacobian(p, target_leveling, J);
+
+            Eigen::Matrix<float, DOF, 3> JtM(J.transpose() * M);
+
+            local_H += (JtM * J).template cast<double>();
+            local_b += (JtM * e.head<3>()).template cast<double>();
+            local_error += double(e.head<3>().dot(M * e.head<3>()));
+
+            ++local_matched;
+
+        }
+
+        #pragma omp critical
+        {
+            H += local_H;
+            b += local_b;
+            error += local_error;
+            matched += local_matched;
+        }
+    }
+
+    return matched;
+
+}
+
+// align the source to the target
+bool VoxelizedGICP::Align(const Eigen::Matrix4f &guess) {
+
+    transformation = guess;
+    converged = false;
+    fitness = std::numeric_limits<double>::max();
+
+    if (source_points.empty() || voxels.empty()) {
+
+        return false;
+
+    }
+
+    return planar ? AlignPlanar(guess) : AlignFull();
+
+}
+
+// the 6 dof alignment
+bool VoxelizedGICP::AlignFull() {
+
+    Eigen::Matrix<double, 6, 6> H;
+    Eigen::Matrix<double, 6, 1> b;
+    double error = 0.0;
+
+    for (unsigned iteration = 0; iteration < max_iterations; ++iteration) {
+
+        std::size_t matched = Linearize<6>(transformation, H, b, error);
+
+        // too few correspondences
+        if (6 > matched) {
+
+            return false;
+
+        }
+
+        fitness = error / matched;
+
+        // the gauss newton step
+        Eigen::Matrix<double, 6, 1> delta(H.ldlt().solve(-b));
+
+        if (!delta.allFinite()) {
+
+            return false;
+
+        }
+
+        // the left update
+        Eigen::Vector3d omega(delta.head<3>());
+        double angle = omega.norm();
+
+        Eigen::Matrix4f update(Eigen::Matrix4f::Identity());
+
+        if (0.0 < angle) {
+
+            update.block<3, 3>(0, 0) = Eigen::AngleAxisd(angle, omega / angle).toRotationMatrix().cast<float>();
+
+        }
+
+        update.block<3, 1>(0, 3) = delta.tail<3>().cast<float>();
+
+        transformation = update * transformation;
+
+        if (epsilon > angle && epsilon > delta.tail<3>().norm()) {
+
+            converged = true;
+
+            return true;
+
+        }
+
+    }
+
+    return false;
+
+}
+
+// the x, y and yaw alignment
+bool VoxelizedGICP::AlignPlanar(const Eigen::Matrix4f &guess) {
+
+    Eigen::Matrix4f source_level(Homogeneous(source_leveling));
+    Eigen::Matrix4f target_level(Homogeneous(target_leveling));
+    Eigen::Matrix4f target_unlevel(Homogeneous(target_leveling.transpose()));
+
+    // the planar part of the guess, between the leveled frames
+    Eigen::Matrix4f leveled_guess(target_level * guess * source_level.transpose());
+
+    Eigen::Matrix4f planar_guess(Homogeneous(Eigen::AngleAxisf(std::atan2(leveled_guess(1, 0), leveled_guess(0, 0)), Eigen::Vector3f::UnitZ()).toRotationMatrix()));
+    planar_guess(0, 3) = leveled_guess(0, 3);
+    planar_guess(1, 3) = leveled_guess(1, 3);
+
+    // the roll and pitch stay fixed from here on
+    transformation = target_unlevel * planar_guess * source_level;
+
+    Eigen::Matrix<double, 3, 3> H;
+    Eigen::Matrix<double, 3, 1> b;
+    double error = 0.0;
+
+    for (unsigned iteration = 0; iteration < max_iterations; ++iteration) {
+
+        std::size_t matched = Linearize<3>(transformation, H, b, error);
+
+        // too few correspondences
+        if (3 > matched) {
+
+            return false;
+
+        }
+
+        fitness = error / matched;
+
+        // the gauss newton step
+        Eigen::Matrix<double, 3, 1> delta(H.ldlt().solve(-b));
+
+        if (!delta.allFinite()) {
+
+            return false;
+
+        }
+
+        // the left update around the leveled z axis
+        Eigen::Matrix4f update(Homogeneous(Eigen::AngleAxisf(float(delta[0]), Eigen::Vector3f::UnitZ()).toRotationMatrix()));
+        update(0, 3) = float(delta[1]);
+        update(1, 3) = float(delta[2]);
+
+        transformation = target_unlevel * update * target_level * transformation;
+
+        if (epsilon > std::fabs(delta[0]) && epsilon > delta.tail<2>().norm()) {
+
+            converged = true;
+
+            return true;
+
+        }
+
+    }
+
+    return false;
+
+}
+
+// the alignment result
+const Eigen::Matrix4f& VoxelizedGICP::FinalTransformation() const {
+
+    return transformation;
+
+}
+
+// the mean mahalanobis error of the matched points
+double VoxelizedGICP::FitnessScore() const {
+
+    return fitness;
+
+}
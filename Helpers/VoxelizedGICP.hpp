@@ -0,0 +1,144 @@
+#ifndef HYPERGRAPHSLAM_VOXELIZED_GICP_HPP
+#define HYPERGRAPHSLAM_VOXELIZED_GICP_HPP
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <CloudFeatures.hpp>
+
+namespace hyper {
+
+// the default voxel size in meters
+#define VGICP_RESOLUTION 1.0
+
+// the default optimization parameters
+#define VGICP_MAX_ITERATIONS 64
+#define VGICP_TRANSFORMATION_EPSILON 1e-4
+
+// the minimum points of a target voxel without the point covariances
+#define VGICP_MIN_VOXEL_POINTS 5
+
+// the ground points hue, painted by the lidar segmentation
+#define VGICP_GROUND_HUE 23.0f
+
+// the minimum ground points of a ground plane fit
+#define VGICP_MIN_GROUND_POINTS 50
+
+// the maximum ground tilt in radians, a larger one is a bad fit and the cloud is not leveled
+#define VGICP_MAX_GROUND_TILT 0.2
+
+// a voxelized generalized icp, in the style of VGICP
+// the target cloud becomes a hash of voxel distributions, so the correspondences are voxel lookups instead of k-d tree searches
+// the points and covariances are padded float4/float4x4 values, so the residual and hessian terms are SIMD friendly
+// the hessian accumulation of a single alignment runs in parallel with OpenMP, when it's enabled
+// the planar mode optimizes only x, y and yaw, the roll and pitch come from the ground planes or are zero
+class VoxelizedGICP {
+
+    private:
+
+        // the padded types
+        typedef std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f>> PointVector;
+        typedef std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>> CovarianceVector;
+
+        // the voxel size
+        float resolution;
+
+        // how many threads inside a single alignment
+        unsigned threads;
+
+        // the optimization parameters
+        unsigned max_iterations;
+        double epsilon;
+
+        // optimize only x, y and yaw
+        bool planar;
+
+        // take the planar mode roll and pitch from the ground planes
+        bool ground_leveling;
+
+        // the rotations that align the ground normals with the z axis
+        Eigen::Matrix3f source_leveling;
+        Eigen::Matrix3f target_leveling;
+
+        // the source points and covariances
+        PointVector source_points;
+        CovarianceVector source_covariances;
+
+        // the target voxels, the hash stores the position inside the distributions
+        std::unordered_map<int64_t, unsigned> voxels;
+        PointVector voxel_means;
+        CovarianceVector voxel_covariances;
+
+        // the alignment result
+        Eigen::Matrix4f transformation;
+        bool converged;
+        double fitness;
+
+        // the voxel key
+        int64_t Key(const Eigen::Vector4f &p) const;
+
+        // keep only the surface shape, unit variance along the surface and epsilon along the normal
+        static Eigen::Matrix4f Regularize(const Eigen::Matrix3d &covariance);
+
+        // the rotation that aligns the ground normal with the z axis, the identity when the ground can't be fitted
+        static Eigen::Matrix3f GroundLeveling(const PointCloudHSV &cloud);
+
+        // accumulate the gauss newton system at the given transformation, it returns how many points have a voxel
+        // DOF 6 is the [rotation, translation] perturbation and DOF 3 is the [yaw, x, y] one in the leveled target frame
+        template<int DOF>
+        std::size_t Linearize(const Eigen::Matrix4f &T, Eigen::Matrix<double, DOF, DOF> &H, Eigen::Matrix<double, DOF, 1> &b, double &error) const;
+
+        // the 6 dof alignment
+        bool AlignFull();
+
+        // the x, y and yaw alignment
+        bool AlignPlanar(const Eigen::Matrix4f &guess);
+
+    public:
+
+        // basic constructor
+        VoxelizedGICP();
+
+        // set the voxel size
+        void SetResolution(double _resolution);
+
+        // set how many threads inside a single alignment
+        void SetThreads(unsigned _threads);
+
+        // set the maximum gauss newton iterations
+        void SetMaxIterations(unsigned _max_iterations);
+
+        // optimize only x, y and yaw
+        void SetPlanar(bool _planar);
+
+        // is it the planar mode?
+        bool IsPlanar() const;
+
+        // fit the ground planes of the next clouds, the planar mode keeps their roll and pitch
+        void SetGroundLeveling(bool _ground_leveling);
+
+        // set the source cloud and its point covariances
+        bool SetSource(const PointCloudHSV &cloud, const CloudFeatures::Covariances &covariances);
+
+        // build the target voxels, the voxel covariance is the mean of the point covariances
+        // without the point covariances, it's the regularized covariance of the voxel points
+        bool SetTarget(const PointCloudHSV &cloud, const CloudFeatures::Covariances *covariances = nullptr);
+
+        // align the source to the target, starting from the guess
+        bool Align(const Eigen::Matrix4f &guess);
+
+        // the alignment result
+        const Eigen::Matrix4f& FinalTransformation() const;
+
+        // the mean mahalanobis error of the matched points
+        double FitnessScore() const;
+
+};
+
+}
+
+#endif
@@ -3,17 +3,20 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
 #include <limits>
 
 #include <png++/png.hpp>
 
+#include <ScratchStorage.hpp>
+
 using namespace hyper;
 
 // the basic constructor
 StampedBumblebee::StampedBumblebee(unsigned msg_id) :
     StampedMessage(msg_id), raw_image(""),
-    left_image("/dados/tmp/images/I1_"),
-    right_image("/dados/tmp/images/I2_"),
+    left_image(ScratchStorage::Path("images/I1_")),
+    right_image(ScratchStorage::Path("images/I2_")),
     width(0),
     height(0),
     size(0),
@@ -133,8 +136,12 @@ bool StampedBumblebee::ParseBumblebeeImage(std::vector<uint8_t> &limg, std::vect
         left_image += ss.str();
         right_image += ss.str();
 
-        lpng.write(left_image);
-        rpng.write(right_image);
+        // the png files are only a visual output, the in memory mode doesn't write them
+        if (!ScratchStorage::InMemory())
+        {
+            lpng.write(left_image);
+            rpng.write(right_image);
+        }
 
         // save the png output image
         result = true;
@@ -143,17 +150,20 @@ bool StampedBumblebee::ParseBumblebeeImage(std::vector<uint8_t> &limg, std::vect
     return result;
 }
 
-// parse the pose from string stream
-bool StampedBumblebee::FromCarmenLog(std::stringstream &ss)
+// parse the pose from the log tokens
+bool StampedBumblebee::FromCarmenLog(LogTokenizer &tokens)
 {
     // read the path
-    ss >> raw_image;
+    tokens.Read(raw_image);
 
     // read the image size
-    ss >> width >> height >> size >> is_rectified;
+    tokens.Read(width);
+    tokens.Read(height);
+    tokens.Read(size);
+    tokens.Read(is_rectified);
 
     // read the timestamp
-    ss >> StampedMessage::timestamp;
+    tokens.Read(StampedMessage::timestamp);
 
     // verify if file exists
     return 0 < width && 0 < height && 0 < size && width * height * 3 == size;
@@ -41,8 +41,8 @@ namespace hyper {
             // the basic destructor
             virtual ~StampedBumblebee();
 
-            // parse the pose from string stream
-            virtual bool FromCarmenLog(std::stringstream &ss);
+            // parse the pose from the log tokens
+            virtual bool FromCarmenLog(LogTokenizer &tokens);
 
             // parse the raw image and save it to the output folder
             bool ParseBumblebeeImage(std::vector<uint8_t> &limg, std::vector<uint8_t> &rimg);
@@ -8,20 +8,20 @@ StampedGPSOrientation::StampedGPSOrientation(unsigned msg_id) : StampedMessage(m
 // basic destructor
 StampedGPSOrientation::~StampedGPSOrientation() {}
 
-// parse the pose from string stream
-bool StampedGPSOrientation::FromCarmenLog(std::stringstream &ss)
+// parse the pose from the log tokens
+bool StampedGPSOrientation::FromCarmenLog(LogTokenizer &tokens)
 {
     // discards the first value
-    SkipValues(ss, 1);
+    tokens.Skip(1);
 
     // read the yaw value
-    ss >> yaw;
+    tokens.Read(yaw);
 
     // discard the next value
-    SkipValues(ss, 1);
+    tokens.Skip(1);
 
     // get the timestamp
-    ss >> StampedMessage::timestamp;
+    tokens.Read(StampedMessage::timestamp);
 
     StampedMessage::timestamp += StampedGPSOrientation::delay;
 
@@ -21,8 +21,8 @@ namespace hyper {
             // basic destructor
             ~StampedGPSOrientation();
 
-            // parse the pose from string stream
-            virtual bool FromCarmenLog(std::stringstream &ss);
+            // parse the pose from the log tokens
+            virtual bool FromCarmenLog(LogTokenizer &tokens);
 
             // get the message type
             virtual StampedMessageType GetType();
@@ -17,50 +17,53 @@ StampedGPSPose::StampedGPSPose(unsigned msg_id) : StampedMessage(msg_id), gps_me
 // basic destructor
 StampedGPSPose::~StampedGPSPose() {}
 
-// parse the pose from string stream
-bool StampedGPSPose::FromCarmenLog(std::stringstream &ss)
+// parse the pose from the log tokens
+bool StampedGPSPose::FromCarmenLog(LogTokenizer &tokens)
 {
     // helpers
-    double lt_dm, lt, lg_dm, lg, sl;
-    char lt_orientation, lg_orientation;
-    int quality;
+    double lt_dm = 0.0, lt, lg_dm = 0.0, lg, sl = 0.0;
+    char lt_orientation = 'N', lg_orientation = 'E';
+    int quality = 0;
 
     // get the gps id
-    ss >> gps_id;
+    tokens.Read(gps_id);
     
-    if (StampedGPSPose::gps_pose_delays.end() != StampedGPSPose::gps_pose_delays.find(gps_id))
+    // the parser threads share the map, so it's only read here
+    std::unordered_map<std::string, std::pair<g2o::SE2, double>>::const_iterator gps_pose_delay = StampedGPSPose::gps_pose_delays.find(gps_id);
+
+    if (StampedGPSPose::gps_pose_delays.end() != gps_pose_delay)
     {
         // discards the second value
-        SkipValues(ss, 1);
+        tokens.Skip(1);
 
         // read the latitude in the dm format
-        ss >> lt_dm;
+        tokens.Read(lt_dm);
 
         // read the latitude orientation
-        ss >> lt_orientation;
+        tokens.Read(lt_orientation);
 
         // read the longitude in the dm format
-        ss >> lg_dm;
+        tokens.Read(lg_dm);
 
         // read the longitude orientation
-        ss >> lg_orientation;
+        tokens.Read(lg_orientation);
 
         // read the gps quality
-        ss >> quality;
+        tokens.Read(quality);
 
         // discards the next two values
-        SkipValues(ss, 2);
+        tokens.Skip(2);
 
         // get the sea level
-        ss >> sl;
+        tokens.Read(sl);
 
         // discards the next 4 values
-        SkipValues(ss, 4);
+        tokens.Skip(4);
 
         // get the timestamp
-        ss >> StampedMessage::timestamp;
+        tokens.Read(StampedMessage::timestamp);
 
-        StampedMessage::timestamp += StampedGPSPose::gps_pose_delays[gps_id].second;
+        StampedMessage::timestamp += gps_pose_delay->second.second;
 
         // @Filipe: desvios padrao para cada modo do GPS Trimble.
         // @Filipe: OBS: Multipliquei os stds por 2 no switch abaixo para dar uma folga.
@@ -112,7 +115,7 @@ bool StampedGPSPose::FromCarmenLog(std::stringstream &ss)
 
         // WARNING
         // WE NEED TO TAKE CARE OF THE YAW VALUES
-        gps_measurement = gps_measurement * StampedGPSPose::gps_pose_delays[gps_id].first;
+        gps_measurement = gps_measurement * gps_pose_delay->second.first;
 
         // set the estimate
         StampedMessage::est = gps_measurement;
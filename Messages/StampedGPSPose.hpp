@@ -1,7 +1,6 @@
 #ifndef HYPERGRAPHSLAM_STAMPED_GPS_POSE_HPP
 #define HYPERGRAPHSLAM_STAMPED_GPS_POSE_HPP
 
-#include <sstream>
 #include <utility>
 #include <vector>
 #include <unordered_map>
@@ -32,8 +31,8 @@ namespace hyper {
 			// basic destructor
 			~StampedGPSPose();
 
-			// parse the pose from string stream
-			virtual bool FromCarmenLog(std::stringstream &ss);
+			// parse the pose from the log tokens
+			virtual bool FromCarmenLog(LogTokenizer &tokens);
 
 			// get the message type
 			virtual StampedMessageType GetType();
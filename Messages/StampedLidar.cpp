@@ -9,14 +9,8 @@ double StampedLidar::to_degree = M_PI / 180.0f;
 // define the default voxel grid leaf filter value
 double StampedLidar::vg_leaf = 0.2;
 
-// the voxel grid
-pcl::VoxelGrid<pcl::PointXYZHSV> StampedLidar::grid_filtering;
-
-// the segmentation class
-SimpleLidarSegmentation StampedLidar::segm;
-
 // the basic constructor
-StampedLidar::StampedLidar(unsigned msg_id, const std::string &base_path) :
+StampedLidar::StampedLidar(unsigned msg_id, PackedCloudStore &store) :
     StampedMessage::StampedMessage(msg_id),
     minx(std::numeric_limits<double>::max()),
     maxx(-std::numeric_limits<double>::max()),
@@ -24,19 +18,16 @@ StampedLidar::StampedLidar(unsigned msg_id, const std::string &base_path) :
     maxy(-std::numeric_limits<double>::max()),
     minz(std::numeric_limits<double>::max()),
     maxz(-std::numeric_limits<double>::max()),
+    cloud_store(&store),
     speed(0.0),
-    path(base_path),
+    cloud_slot(PackedCloudStore::invalid_slot),
+    descriptor(),
     seq_measurement(0.0, 0.0, 0.0),
     seq_id(std::numeric_limits<unsigned>::max()),
     lidar_estimate(0.0, 0.0, 0.0),
     gps_sync_estimate(0.0, 0.0, 0.0),
     loop_measurement(0.0, 0.0, 0.0),
-    loop_closure_id(std::numeric_limits<unsigned>::max()) {
-
-    // set the default leaf size
-    StampedLidar::grid_filtering.setLeafSize(vg_leaf, vg_leaf, vg_leaf);
-
-}
+    loop_closure_id(std::numeric_limits<unsigned>::max()) {}
 
 // the basic destructor
 StampedLidar::~StampedLidar() {}
@@ -64,8 +55,15 @@ pcl::PointXYZHSV StampedLidar::FromSpherical(double phi, double theta, double ra
 
 }
 
+// append the filtered cloud to the sensor store
+bool StampedLidar::SaveCloud(const PointCloudHSV &cloud) {
+
+    return cloud_store->Append(cloud, cloud_slot);
+
+}
+
 // save the point cloud
-void StampedLidar::SavePointCloud(const std::string &base_path, unsigned cloud_id, const PointCloudHSV &cloud) {
+void StampedLidar::SavePointCloud(const std::string &base_path, unsigned cloud_id, const PointCloudHSV &cloud, bool compressed) {
 
     if (0 < cloud.size()) {
 
@@ -76,7 +74,9 @@ void StampedLidar::SavePointCloud(const std::string &base_path, unsigned cloud_i
         ss << base_path << "cloud" << cloud_id << ".pcd";
 
         // save the cloud
-        if (-1 == pcl::io::savePCDFile(ss.str(), cloud, true)) {
+        int status = compressed ? pcl::io::savePCDFileBinaryCompressed(ss.str(), cloud) : pcl::io::savePCDFile(ss.str(), cloud, true);
+
+        if (-1 == status) {
 
             throw std::runtime_error("Could not save the cloud");
 
@@ -162,10 +162,32 @@ void StampedLidar::LoadPointCloud(const std::string &cloud_path, PointCloudHSV &
 
 }
 
+// load the point cloud from the sensor store
+bool StampedLidar::LoadCloud(PointCloudHSV &cloud) const {
+
+    return cloud_store->Load(cloud_slot, cloud);
+
+}
+
+// the sensor store
+const PackedCloudStore& StampedLidar::CloudStore() const {
+
+    return *cloud_store;
+
+}
+
 // remove undesired points
-void StampedLidar::RemoveUndesiredPoints(PointCloudHSV &cloud) {
+void StampedLidar::RemoveUndesiredPoints(SimpleLidarSegmentation &segm, PointCloudHSV &cloud) {
 
     // segmentation
     segm.PointTypeSegmentation(cloud, absx, absy, minz, maxz);
 
-}
\ No newline at end of file
+}
+
+// the fraction of the other scan structure that falls on this scan structure
+double StampedLidar::EstimateOverlap(const StampedLidar &other, const g2o::SE2 &motion) const {
+
+    // the other scan structure in this scan frame
+    return LidarFootprint::Overlap(footprint, other.footprint, motion[0], motion[1], motion[2]);
+
+}
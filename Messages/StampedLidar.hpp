@@ -7,6 +7,9 @@
 
 #include <StringHelper.hpp>
 #include <SimpleLidarSegmentation.hpp>
+#include <PackedCloudStore.hpp>
+#include <ScanContext.hpp>
+#include <LidarFootprint.hpp>
 
 namespace hyper {
 
@@ -28,25 +31,31 @@ class StampedLidar : virtual public StampedMessage {
         // z min max values
         double minz, maxz, absz;
 
-        // the segmentation class
-        static hyper::SimpleLidarSegmentation segm;
+        // the sensor cloud store
+        PackedCloudStore *cloud_store;
 
         // convert from spherical coordinates
         pcl::PointXYZHSV FromSpherical(double phi, double theta, double radius);
 
+        // append the filtered cloud to the sensor store
+        bool SaveCloud(const PointCloudHSV &cloud);
+
     public:
 
         // the default leaf size
         static double vg_leaf;
 
-        // the cloud filtering object
-        static VoxelGridFilter grid_filtering;
-
         // the current speed, for filtering purpose
         double speed;
 
-        // the point cloud filepath
-        std::string path;
+        // the point cloud slot inside the sensor store
+        std::size_t cloud_slot;
+
+        // the place recognition descriptor
+        ScanContext descriptor;
+
+        // the range limited occupancy footprint, used to estimate the overlap between scans
+        LidarFootprint footprint;
 
         // the sequential ICP measure
         g2o::SE2 seq_measurement;
@@ -67,16 +76,16 @@ class StampedLidar : virtual public StampedMessage {
         unsigned loop_closure_id;
 
         // the basic constructor
-        StampedLidar(unsigned msg_id, const std::string &base_path);
+        StampedLidar(unsigned msg_id, PackedCloudStore &store);
 
         // the basic destructor
         virtual ~StampedLidar();
 
-        // parse the pose from string stream
-        virtual bool FromCarmenLog(std::stringstream &ss) =0;
+        // parse the pose from the log tokens
+        virtual bool FromCarmenLog(LogTokenizer &tokens) =0;
 
-        // save the point cloud
-        static void SavePointCloud(const std::string &base_path, unsigned cloud_id, const PointCloudHSV &cloud);
+        // save the point cloud, in the binary or in the compressed binary pcd format
+        static void SavePointCloud(const std::string &base_path, unsigned cloud_id, const PointCloudHSV &cloud, bool compressed = false);
 
         // custom point cloud saving process
         static void SavePointCloud(const std::string &cloud_path, const PointCloudHSV &cloud);
@@ -84,8 +93,18 @@ class StampedLidar : virtual public StampedMessage {
         // custom point cloud loading process
         static void LoadPointCloud(const std::string &cloud_path, PointCloudHSV &cloud);
 
-        // remove undesired points
-        void RemoveUndesiredPoints(PointCloudHSV &cloud);
+        // load the point cloud from the sensor store
+        virtual bool LoadCloud(PointCloudHSV &cloud) const;
+
+        // the sensor store, used by the cloud cache
+        const PackedCloudStore& CloudStore() const;
+
+        // remove undesired points, each decoder thread has its own segmentation object
+        void RemoveUndesiredPoints(SimpleLidarSegmentation &segm, PointCloudHSV &cloud);
+
+        // the fraction of the other scan structure that falls on this scan structure, from 0 to 1
+        // the motion is the other scan pose in this scan frame, both footprints are limited to LIDAR_FOOTPRINT_RADIUS
+        double EstimateOverlap(const StampedLidar &other, const g2o::SE2 &motion) const;
 
 };
 
@@ -2,39 +2,17 @@
 #define HYPERGRAPHSLAM_STAMPED_MESSAGE_HPP
 
 #include <limits>
-#include <sstream>
 #include <vector>
 
 #include <g2o/types/slam2d/se2.h>
 
 #include <StampedMessageType.hpp>
+#include <LogTokenizer.hpp>
 
 namespace hyper {
 
     class StampedMessage
     {
-        protected:
-
-            // skip n values inside the string stream
-            // considering the space character ' ' as the limiter one
-            void SkipValues(std::stringstream &ss, unsigned n)
-            {
-                if (0 < n)
-                {
-                    // we need one extra skiping procedure
-                    ++n;
-
-                    while (0 < n)
-                    {
-                        // ignore the current value
-                        ss.ignore(std::numeric_limits<std::streamsize>::max(), ' ');
-
-                        // consume one iteration
-                        --n;
-                    }
-                }
-            }
-
         public:
 
             // the usual timestamp
@@ -67,8 +45,8 @@ namespace hyper {
             // the basic destructor
             virtual ~StampedMessage() {}
 
-            // parse the pose from string stream
-            virtual bool FromCarmenLog(std::stringstream &ss) =0;
+            // parse the pose from the log line tokens, the tag is already consumed
+            virtual bool FromCarmenLog(LogTokenizer &tokens) =0;
 
             // a static method to compare pointers of stamped messages
             static bool compare(StampedMessage *a, StampedMessage *b)
@@ -0,0 +1,106 @@
+#include <StampedMessageStore.hpp>
+
+using namespace hyper;
+
+// append an odometry message
+void StampedMessageStore::Push(StampedOdometryPtr odom)
+{
+    // save the commands
+    odometry.push_back({ odom->v, odom->phi, odom->raw_v, odom->raw_phi });
+
+    // the common columns
+    Push(odom, StampedOdometryMessage, odometry.size() - 1);
+}
+
+
+// append a gps pose message
+void StampedMessageStore::Push(StampedGPSPosePtr gps_pose)
+{
+    // save the gps measure
+    gps_measurement.push_back(gps_pose->gps_measurement);
+    gps_index.Push(gps_pose->timestamp, gps_measurement.size() - 1);
+
+    // the common columns
+    Push(gps_pose, StampedGPSMessage, gps_measurement.size() - 1);
+}
+
+
+// append a gps orientation message
+void StampedMessageStore::Push(StampedGPSOrientationPtr gps_orientation)
+{
+    // save the heading
+    gps_yaw.push_back(gps_orientation->yaw);
+    gps_yaw_index.Push(gps_orientation->timestamp, gps_yaw.size() - 1);
+
+    // the common columns
+    Push(gps_orientation, StampedGPSOrientationMessage, gps_yaw.size() - 1);
+}
+
+
+// append any other message
+void StampedMessageStore::Push(StampedMessagePtr msg, StampedMessageType type, unsigned position)
+{
+    types.push_back(type);
+    timestamps.push_back(msg->timestamp);
+    ids.push_back(msg->id);
+    est.push_back(msg->est);
+    odom_measurement.push_back(msg->odom_measurement);
+    raw_est.push_back(msg->raw_est);
+    raw_measurement.push_back(msg->raw_measurement);
+    handles.push_back(msg);
+    payload.push_back(position);
+}
+
+
+// copy the gps measures from the gps messages
+void StampedMessageStore::GatherGPS(const StampedGPSPosePtrVector &gps_messages)
+{
+    // the gps messages were pushed in the same order
+    for (unsigned i = 0; i < gps_measurement.size() && i < gps_messages.size(); ++i)
+    {
+        gps_measurement[i] = gps_messages[i]->gps_measurement;
+    }
+}
+
+
+// copy the estimates and measures back to the messages
+void StampedMessageStore::Scatter()
+{
+    for (unsigned i = 0; i < handles.size(); ++i)
+    {
+        // direct access
+        StampedMessagePtr msg = handles[i];
+
+        msg->est = est[i];
+        msg->odom_measurement = odom_measurement[i];
+        msg->raw_est = raw_est[i];
+        msg->raw_measurement = raw_measurement[i];
+    }
+}
+
+
+// how many messages
+unsigned StampedMessageStore::Size() const
+{
+    return types.size();
+}
+
+
+// remove all messages
+void StampedMessageStore::Clear()
+{
+    types.clear();
+    timestamps.clear();
+    ids.clear();
+    est.clear();
+    odom_measurement.clear();
+    raw_est.clear();
+    raw_measurement.clear();
+    handles.clear();
+    payload.clear();
+    odometry.clear();
+    gps_measurement.clear();
+    gps_yaw.clear();
+    gps_index.Clear();
+    gps_yaw_index.Clear();
+}
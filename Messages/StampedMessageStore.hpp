@@ -0,0 +1,85 @@
+#ifndef HYPERGRAPHSLAM_STAMPED_MESSAGE_STORE_HPP
+#define HYPERGRAPHSLAM_STAMPED_MESSAGE_STORE_HPP
+
+#include <vector>
+
+#include <StampedMessage.hpp>
+#include <StampedOdometry.hpp>
+#include <StampedGPSPose.hpp>
+#include <StampedGPSOrientation.hpp>
+#include <TimeIndex.hpp>
+
+namespace hyper {
+
+    // the odometry commands
+    struct OdometryCommand
+    {
+        double v, phi;
+        double raw_v, raw_phi;
+    };
+
+    // the sorted messages as column arrays with an explicit type tag
+    // the sequential passes iterate over the columns instead of downcasting every message
+    // the index i refers to the same message in all the common columns
+    class StampedMessageStore
+    {
+        public:
+
+            // the message types
+            std::vector<StampedMessageType> types;
+
+            // the timestamps
+            std::vector<double> timestamps;
+
+            // the message ids
+            std::vector<unsigned> ids;
+
+            // the SE2 estimates and measures
+            std::vector<g2o::SE2> est;
+            std::vector<g2o::SE2> odom_measurement;
+            std::vector<g2o::SE2> raw_est;
+            std::vector<g2o::SE2> raw_measurement;
+
+            // the original messages
+            std::vector<StampedMessagePtr> handles;
+
+            // the message position inside the per type arrays, or inside the per type lists when there's no per type column
+            std::vector<unsigned> payload;
+
+            // the per type columns
+            std::vector<OdometryCommand> odometry;
+            std::vector<g2o::SE2> gps_measurement;
+            std::vector<double> gps_yaw;
+
+            // the per type time indexes, the values are the positions inside the per type columns
+            TimeIndex gps_index;
+            TimeIndex gps_yaw_index;
+
+            // append an odometry message
+            void Push(StampedOdometryPtr odom);
+
+            // append a gps pose message
+            void Push(StampedGPSPosePtr gps_pose);
+
+            // append a gps orientation message
+            void Push(StampedGPSOrientationPtr gps_orientation);
+
+            // append any other message, the payload is the message position inside its own list
+            void Push(StampedMessagePtr msg, StampedMessageType type, unsigned position);
+
+            // copy the gps measures from the gps messages, in the same order they were pushed
+            void GatherGPS(const StampedGPSPosePtrVector &gps_messages);
+
+            // copy the estimates and measures back to the messages
+            void Scatter();
+
+            // how many messages
+            unsigned Size() const;
+
+            // remove all messages
+            void Clear();
+    };
+
+}
+
+#endif
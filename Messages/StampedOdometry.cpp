@@ -19,17 +19,17 @@ StampedOdometry::StampedOdometry(unsigned msg_id) :
 StampedOdometry::~StampedOdometry() {}
 
 
-// parse odometry from string stream
-bool StampedOdometry::FromCarmenLog(std::stringstream &ss)
+// parse odometry from the log tokens
+bool StampedOdometry::FromCarmenLog(LogTokenizer &tokens)
 {
     // read the velocity value
-    ss >> raw_v;
+    tokens.Read(raw_v);
 
     // read the phi value
-    ss >> raw_phi;
+    tokens.Read(raw_phi);
 
     // read the timestamp value
-    ss >> StampedOdometry::timestamp;
+    tokens.Read(StampedOdometry::timestamp);
 
     // filtering
     if (0.001 > std::fabs(v))
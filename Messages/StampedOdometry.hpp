@@ -18,8 +18,8 @@ namespace hyper {
 			// basic destructor
 			~StampedOdometry();
 
-			// parse odometry from string stream
-			virtual bool FromCarmenLog(std::stringstream &ss);
+			// parse odometry from the log tokens
+			virtual bool FromCarmenLog(LogTokenizer &tokens);
 
 			// get the message type
             virtual StampedMessageType GetType();
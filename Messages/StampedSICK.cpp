@@ -4,66 +4,72 @@
 #include <bitset>
 
 #include <pcl/point_cloud.h>
-#include <pcl/io/pcd_io.h>
 
 using namespace hyper;
 
-const std::string StampedSICK::base_sick_path = "/dados/tmp/sick/sick";
+// the cloud store file, inside the scratch directory
+const std::string StampedSICK::base_sick_path = "sick/sick.clouds";
+
+// the packed sick clouds
+PackedCloudStore StampedSICK::cloud_store;
 
 // set the mirror mask
 const uint16_t StampedSICK::MIRROR_MASK = 0x1 << 3;
 
 // the basic constructor
-StampedSICK::StampedSICK(unsigned msg_id) : StampedMessage(msg_id), StampedLidar(msg_id, base_sick_path) {}
+StampedSICK::StampedSICK(unsigned msg_id) : StampedMessage(msg_id), StampedLidar(msg_id, cloud_store) {}
 
 // the basic destructor
 StampedSICK::~StampedSICK() {}
 
 // PUBLIC METHODS
 
-// parse the pose from string stream
-bool StampedSICK::FromCarmenLog(std::stringstream &ss)
+// parse the pose from the log tokens
+bool StampedSICK::FromCarmenLog(LogTokenizer &tokens)
 {
     // helpers
-    uint16_t scanner_status;
-    unsigned points;
-    double h_angle, v_angle, distance;
+    uint16_t scanner_status = 0;
+    unsigned points = 0;
+    double h_angle = 0.0, v_angle = 0.0, distance = 0.0;
 
     // the PCL point cloud
     PointCloudHSV cloud;
 
     // discards the first value
-    SkipValues(ss, 1);
+    tokens.Skip(1);
 
     // get the scanner status flag
-    ss >> scanner_status;
+    tokens.Read(scanner_status);
 
     // apply the mask and verify
     if (scanner_status & MIRROR_MASK)
     {
         // discards the next six values
-        SkipValues(ss, 6);
+        tokens.Skip(6);
 
         // get the number of points
-        ss >> points;
+        tokens.Read(points);
 
         // discards the next value
-        SkipValues(ss, 1);
+        tokens.Skip(1);
+
+        // avoid the reallocations
+        cloud.reserve(points);
 
         // read all points
         for (unsigned i = 0; i < points; ++i)
         {
             // get the horizontal angle
-            ss >> h_angle;
+            tokens.Read(h_angle);
 
             // get the vertical angle
-            ss >> v_angle;
+            tokens.Read(v_angle);
 
             // get the distance
-            ss >> distance;
+            tokens.Read(distance);
 
             // discards the next 3 values
-            SkipValues(ss, 3);
+            tokens.Skip(3);
 
             // and save it to the point cloud
             cloud.push_back(StampedLidar::FromSpherical(h_angle, M_PI_2 - v_angle, distance));
@@ -71,20 +77,16 @@ bool StampedSICK::FromCarmenLog(std::stringstream &ss)
         }
 
         // get the timestamp
-        ss >> StampedMessage::timestamp;
+        tokens.Read(StampedMessage::timestamp);
 
-        // save the cloud
-        std::stringstream ss_parser;
-        ss_parser << StampedMessage::id;
+        // the place recognition descriptor
+        StampedLidar::descriptor.Build(cloud);
 
-        // save the name
-        StampedLidar::path += (ss_parser.str() + ".pcd");
+        // the overlap footprint, the planar scan has no segmentation
+        StampedLidar::footprint.Build(cloud, false);
 
-        // save the pcd file
-        if (-1 != pcl::io::savePCDFile(StampedLidar::path, cloud, true))
-        {
-            return true;
-        }
+        // append the cloud to the packed store, the message keeps the slot
+        return StampedLidar::SaveCloud(cloud);
     }
 
     return false;
@@ -11,22 +11,25 @@ namespace hyper {
     {
         protected:
 
-            // the default sick file path
-            static const std::string base_sick_path;
-
             // the mirror mask
             static const uint16_t MIRROR_MASK;
 
         public:
 
+            // the sick cloud store file, relative to the scratch directory
+            static const std::string base_sick_path;
+
+            // the packed sick clouds
+            static PackedCloudStore cloud_store;
+
             // the basic constructor
             StampedSICK(unsigned msg_id);
 
             // the basic destructor
             virtual ~StampedSICK();
 
-            // parse the pose from string stream
-            virtual bool FromCarmenLog(std::stringstream &ss);
+            // parse the pose from the log tokens
+            virtual bool FromCarmenLog(LogTokenizer &tokens);
 
             // get the message type
             virtual StampedMessageType GetType();
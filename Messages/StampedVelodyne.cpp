@@ -1,14 +1,17 @@
 #include <StampedVelodyne.hpp>
+#include <VelodyneHexDecoder.hpp>
 #include <fstream>
-#include <cctype>
 #include <clocale>
-
-#include <pcl/io/pcd_io.h>
+#include <limits>
+#include <algorithm>
 
 using namespace hyper;
 
-// the base path
-const std::string StampedVelodyne::base_velodyne_path = "/dados/tmp/velodyne/velodyne";
+// the cloud store file, inside the scratch directory
+const std::string StampedVelodyne::base_velodyne_path = "velodyne/velodyne.clouds";
+
+// the packed velodyne clouds
+PackedCloudStore StampedVelodyne::cloud_store;
 
 // the double size
 const unsigned StampedVelodyne::double_size = sizeof(double);
@@ -62,49 +65,170 @@ const double StampedVelodyne::vertical_correction[32] =
     M_PI_2 - 0.1862266311877949498398976402313564904034137725830078125
 };
 
+// the vertical angles used by the binary scan files
+const StampedVelodyne::LaserTable StampedVelodyne::file_lasers = StampedVelodyne::BuildLaserTable(false);
+
+// the vertical angles used by the in-log scans
+const StampedVelodyne::LaserTable StampedVelodyne::log_lasers = StampedVelodyne::BuildLaserTable(true);
+
+// the in-log encoder positions, hundredths of degree
+const unsigned StampedVelodyne::azimuth_steps = 36000;
+
 // the basic constructor
-StampedVelodyne::StampedVelodyne(unsigned msg_id) : StampedMessage(msg_id), StampedLidar(msg_id, base_velodyne_path), vertical_scans(0) {}
+StampedVelodyne::StampedVelodyne(unsigned msg_id) :
+    StampedMessage(msg_id), StampedLidar(msg_id, cloud_store), scan_path(""), raw_scan(""), vertical_scans(0) {}
 
 
 // the basic destructor
 StampedVelodyne::~StampedVelodyne() {}
 
 
-// read the point cloud from file
-PointCloudHSV::Ptr StampedVelodyne::ReadVelodyneCloudFromFile(std::stringstream &ss)
+// build the laser table
+StampedVelodyne::LaserTable StampedVelodyne::BuildLaserTable(bool from_log)
 {
-    // the pcl object
-    PointCloudHSV::Ptr input_cloud(new PointCloudHSV());
+    LaserTable lasers;
+
+    for (unsigned j = 0; j < 32; ++j)
+    {
+        // the in-log scans use the complementary angle
+        double theta = from_log ? M_PI_2 - vertical_correction[j] : vertical_correction[j];
+
+        // save the float values
+        lasers.theta[j] = float(theta);
+        lasers.sin_theta[j] = float(std::sin(theta));
+        lasers.cos_theta[j] = float(std::cos(theta));
+    }
+
+    return lasers;
+}
+
+
+// the cached in-log azimuth sines and cosines
+const std::vector<float>& StampedVelodyne::AzimuthTable()
+{
+    // thread safe initialization, the decoder threads share the same table
+    static const std::vector<float> table = []()
+    {
+        // the sine and cosine pairs
+        std::vector<float> values(2 * azimuth_steps);
+
+        for (unsigned k = 0; k < azimuth_steps; ++k)
+        {
+            // the same conversion applied to the log values
+            double phi = -0.01 * to_degree * k;
 
-    // helpers
-    std::string velodyne_log_path;
+            values[2 * k] = float(std::sin(phi));
+            values[2 * k + 1] = float(std::cos(phi));
+        }
+
+        return values;
+    }();
+
+    return table;
+}
+
+
+// convert a column of 32 ranges sharing the same azimuth
+unsigned StampedVelodyne::ConvertColumn(
+    const LaserTable &lasers, float phi, float sin_phi, float cos_phi,
+    const float *distances, uint32_t first_cell, pcl::PointXYZHSV *output, uint32_t *cells, CloudBounds &bounds)
+{
+    // the cartesian coords of the entire column, this loop has no branches so it can be vectorized
+    float x[32], y[32], z[32];
+
+    for (unsigned j = 0; j < 32; ++j)
+    {
+        // precalculate a commom value
+        float rsin = distances[j] * lasers.sin_theta[j];
+
+        // get the rectangular coordinates
+        x[j] = rsin * cos_phi;
+        y[j] = rsin * sin_phi;
+        z[j] = distances[j] * lasers.cos_theta[j];
+    }
+
+    // how many valid points
+    unsigned count = 0;
+
+    for (unsigned j = 0; j < 32; ++j)
+    {
+        if (4.0f < distances[j] && 100.0f > distances[j] && -2.9f < z[j])
+        {
+            // update the min max values
+            if (bounds.minx > x[j]) bounds.minx = x[j];
+            if (bounds.maxx < x[j]) bounds.maxx = x[j];
 
-    // get the filepath
-    ss >> velodyne_log_path;
+            if (bounds.miny > y[j]) bounds.miny = y[j];
+            if (bounds.maxy < y[j]) bounds.maxy = y[j];
 
-    // get the number of vertical scans
-    // each vertical scans has 32 laser beams
-    ss >> vertical_scans;
+            if (bounds.minz > z[j]) bounds.minz = z[j];
+            if (bounds.maxz < z[j]) bounds.maxz = z[j];
 
-    // get the timestamp
-    ss >> StampedMessage::timestamp;
+            // the range image cell
+            cells[count] = first_cell + j;
+
+            // write the point in place
+            pcl::PointXYZHSV &point(output[count++]);
+
+            point.x = x[j];
+            point.y = y[j];
+            point.z = z[j];
+
+            // set the intensity
+            point.h = phi;
+            point.s = lasers.theta[j];
+            point.v = distances[j];
+        }
+    }
+
+    return count;
+}
+
+
+// update the min, max and abs values
+void StampedVelodyne::SetBounds(const CloudBounds &bounds)
+{
+    // the min max values
+    minx = std::min(minx, double(bounds.minx));
+    maxx = std::max(maxx, double(bounds.maxx));
+
+    miny = std::min(miny, double(bounds.miny));
+    maxy = std::max(maxy, double(bounds.maxy));
+
+    minz = std::min(minz, double(bounds.minz));
+    maxz = std::max(maxz, double(bounds.maxz));
+
+    // set the abs values
+    absx = std::fabs(maxx) > std::fabs(minx) ? std::fabs(maxx) : std::fabs(minx);
+    absy = std::fabs(maxy) > std::fabs(miny) ? std::fabs(maxy) : std::fabs(miny);
+    absz = std::fabs(maxz) > std::fabs(minz) ? std::fabs(maxz) : std::fabs(minz);
+}
+
+
+// read the point cloud from file
+PointCloudHSV::Ptr StampedVelodyne::ReadVelodyneCloudFromFile(VelodyneRangeImage &image, std::vector<uint32_t> &cells)
+{
+    // the pcl object
+    PointCloudHSV::Ptr input_cloud(new PointCloudHSV());
 
     // open the pointcloud file
-    std::ifstream source(velodyne_log_path, std::ifstream::in | std::ifstream::binary);
+    std::ifstream source(scan_path, std::ifstream::in | std::ifstream::binary);
 
     if (!source.is_open())
     {
         // error
         std::string error("Could not open the velodyne point cloud: ");
-        error += velodyne_log_path;
+        error += scan_path;
 
         // return the empty pointer
         throw std::runtime_error(error);
     }
 
-    // the point cloud values
-    double h_angle, v_angle;
-    double distance;
+    // the horizontal angle
+    double h_angle;
+
+    // the column distances
+    float distances[32];
 
     // the input data size in bytes
     unsigned data_size = velodyne_struct_size * vertical_scans;
@@ -118,6 +242,26 @@ PointCloudHSV::Ptr StampedVelodyne::ReadVelodyneCloudFromFile(std::stringstream
     // close the file
     source.close();
 
+    // the points are written in place, so we need the maximum size
+    PointCloudHSV::VectorType &points(input_cloud->points);
+    points.resize(vertical_scans * 32);
+    cells.resize(vertical_scans * 32);
+
+    // the raw ranges are in 2 millimeters units
+    image.Resize(vertical_scans);
+    image.range_scale = 0.002f;
+    image.from_log = false;
+
+    // how many valid points
+    unsigned count = 0;
+
+    // the float limits
+    CloudBounds bounds = {
+        std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()
+    };
+
     // read all the point cloud file
     for (unsigned i = 0; i < vertical_scans; ++i)
     {
@@ -132,37 +276,28 @@ PointCloudHSV::Ptr StampedVelodyne::ReadVelodyneCloudFromFile(std::stringstream
 
         for (unsigned j = 0; j < 32; ++j)
         {
-            // get the vertical angle
-            v_angle = vertical_correction[j];
+            // the raw range, the negative values are invalid anyway
+            image.ranges[32 * i + j] = uint16_t(std::max(short(0), dp[j]));
 
             // get the distance value
-            distance = ((double) dp[j]) * 0.002;
-
-            // conver to cartesian coords
-            pcl::PointXYZHSV point(StampedLidar::FromSpherical(h_angle, v_angle, distance));
-
-            if (4.0 < distance && 100.0 > distance && -2.9 < point.z)
-            {
-                // update the min max values
-                if (minx > point.x) minx = point.x;
-                if (maxx < point.x) maxx = point.x;
-
-                if (miny > point.y) miny = point.y;
-                if (maxy < point.y) maxy = point.y;
+            distances[j] = float(dp[j]) * 0.002f;
+        }
 
-                if (minz > point.z) minz = point.z;
-                if (maxz < point.z) maxz = point.z;
+        // the column azimuth
+        image.azimuth[i] = float(h_angle);
 
-                // get the hsv point
-                input_cloud->push_back(point);
-            }
-        }
+        // conver the entire column to cartesian coords, the azimuth sine and cosine are computed once
+        count += ConvertColumn(file_lasers, float(h_angle), float(std::sin(h_angle)), float(std::cos(h_angle)), distances, 32 * i, &points[count], &cells[count], bounds);
     }
 
-    // set the abs values
-    absx = std::fabs(maxx) > std::fabs(minx) ? std::fabs(maxx) : std::fabs(minx);
-    absy = std::fabs(maxy) > std::fabs(miny) ? std::fabs(maxy) : std::fabs(miny);
-    absz = std::fabs(maxz) > std::fabs(minz) ? std::fabs(maxz) : std::fabs(minz);
+    // the valid points only
+    points.resize(count);
+    cells.resize(count);
+    input_cloud->width = count;
+    input_cloud->height = 1;
+
+    // set the min, max and abs values
+    SetBounds(bounds);
 
     // remove the buffer from memmory
     delete [] binary_buffer;
@@ -172,134 +307,176 @@ PointCloudHSV::Ptr StampedVelodyne::ReadVelodyneCloudFromFile(std::stringstream
 }
 
 // read the point cloud from carmen log
-PointCloudHSV::Ptr StampedVelodyne::ReadVelodyneCloudFromLog(std::stringstream &ss)
+PointCloudHSV::Ptr StampedVelodyne::ReadVelodyneCloudFromLog(VelodyneRangeImage &image, std::vector<uint32_t> &cells)
 {
     // the input cloud
     PointCloudHSV::Ptr input_cloud(new PointCloudHSV());
 
-    // beam info
-    double h_angle, v_angle, distance;
+    // the raw scan tokens
+    LogTokenizer tokens(raw_scan.data(), raw_scan.data() + raw_scan.size());
+
+    // the raw horizontal angle
+    double encoder;
 
-    // the first, second and fourth nibbles
-    unsigned char nibbles[4];
+    // the column distances
+    float distances[32];
 
-    // helper
-    int r;
+    // the cached azimuth values
+    const std::vector<float> &azimuth(AzimuthTable());
 
     // how many vertical scans
-    ss >> vertical_scans;
+    tokens.Read(vertical_scans);
 
-    // read all data
-    for (unsigned i = 0; i < vertical_scans; ++i)
-    {
-        // read the horizontal angle
-        ss >> h_angle;
+    // the points are written in place, so we need the maximum size
+    PointCloudHSV::VectorType &points(input_cloud->points);
+    points.resize(vertical_scans * 32);
+    cells.resize(vertical_scans * 32);
 
-        // apply the conversion
-        h_angle *= -0.01 * to_degree;
+    // the raw ranges are in 2 centimeters units
+    image.Resize(vertical_scans);
+    image.range_scale = 0.02f;
+    image.from_log = true;
+
+    // how many valid points
+    unsigned count = 0;
 
-        // string to read the entire vertical scan
-        std::string scan("");
+    // the float limits
+    CloudBounds bounds = {
+        std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()
+    };
 
-        // read the current vertical scan
-        ss >> scan;
+    // read all data
+    for (unsigned i = 0; i < vertical_scans; ++i)
+    {
+        // read the encoder position, hundredths of degree
+        tokens.Read(encoder);
 
-        // the current position index
-        unsigned current_pos = 0;
+        // the entire vertical scan, in place
+        LogLine scan;
 
         // each individual vertical scan should have the same 32 lasers
         // so the scan string should have 192 bytes
+        if (!tokens.Next(scan) || VELODYNE_HEX_COLUMN_SIZE > scan.size())
+        {
+            break;
+        }
+
+        // decode the 32 ranges at once, straight to the range image
+        uint16_t *ranges = &image.ranges[32 * i];
+        VelodyneHexDecoder::DecodeColumn(scan.begin, ranges);
+
         for (unsigned j = 0; j < 32; ++j)
         {
-            // get the vertical angle
-            v_angle = M_PI_2 - vertical_correction[j];
+            // get the distance value
+            distances[j] = float(ranges[j]) * 0.02f;
+        }
 
-            for (unsigned k = 0; k < 4; ++k)
-            {
-                // get the current nibble, then move forward the current position index
-                r = scan[current_pos++];
+        // apply the conversion
+        double h_angle = encoder * -0.01 * to_degree;
 
-                // convert the int value to char, bit shifting operation
-                nibbles[k] = std::isalpha(r) ? r - 'a' + 10 : r - '0';
-            }
+        // the column azimuth
+        image.azimuth[i] = float(h_angle);
 
-            // move the current position two byte ahead, it discards the intensity value
-            current_pos += 2;
+        // the table index
+        unsigned step = 0.0 <= encoder ? unsigned(encoder) : azimuth_steps;
 
-            // convert the four nibbles to the distance value
-            distance = (nibbles[3] << 12 | (nibbles[2] << 8 | (nibbles[1] << 4 | nibbles[0]))) * 0.02;
+        if (azimuth_steps > step && double(step) == encoder)
+        {
+            // use the cached sine and cosine
+            count += ConvertColumn(log_lasers, float(h_angle), azimuth[2 * step], azimuth[2 * step + 1], distances, 32 * i, &points[count], &cells[count], bounds);
+        }
+        else
+        {
+            // unusual encoder values
+            count += ConvertColumn(log_lasers, float(h_angle), float(std::sin(h_angle)), float(std::cos(h_angle)), distances, 32 * i, &points[count], &cells[count], bounds);
+        }
+    }
 
-            // conver to cartesian coords
-            pcl::PointXYZHSV point(StampedLidar::FromSpherical(h_angle, v_angle, distance));
+    // the valid points only
+    points.resize(count);
+    cells.resize(count);
+    input_cloud->width = count;
+    input_cloud->height = 1;
 
-            if (4.0 < distance && 100.0 > distance && -2.9 < point.z)
-            {
-                // update the min max values
-                if (minx > point.x) minx = point.x;
-                if (maxx < point.x) maxx = point.x;
+    // set the min, max and abs values
+    SetBounds(bounds);
 
-                if (miny > point.y) miny = point.y;
-                if (maxy < point.y) maxy = point.y;
+    // return the current cloud
+    return input_cloud;
+}
 
-                if (minz > point.z) minz = point.z;
-                if (maxz < point.z) maxz = point.z;
+// parse the pose from the log tokens
+bool StampedVelodyne::FromCarmenLog(LogTokenizer &tokens)
+{
+    if (1e04 > tokens.Remaining())
+    {
+        // get the filepath
+        tokens.Read(scan_path);
 
-                // get the hsv point
-                input_cloud->push_back(point);
-            }
+        // get the number of vertical scans
+        // each vertical scans has 32 laser beams
+        tokens.Read(vertical_scans);
 
-            // get the next point and save it to the point cloud
-            input_cloud->push_back(StampedLidar::FromSpherical(h_angle, v_angle, distance));
-        }
+        // get the timestamp
+        tokens.Read(StampedMessage::timestamp);
+    }
+    else
+    {
+        // keep the entire scan to the decoder
+        raw_scan = tokens.Rest().ToString();
     }
 
-    // set the abs values
-    absx = std::fabs(maxx) > std::fabs(minx) ? std::fabs(maxx) : std::fabs(minx);
-    absy = std::fabs(maxy) > std::fabs(miny) ? std::fabs(maxy) : std::fabs(miny);
-    absz = std::fabs(maxz) > std::fabs(minz) ? std::fabs(maxz) : std::fabs(minz);
-
-    // return the current cloud
-    return input_cloud;
+    return true;
 }
 
-// parse the pose from string stream
-bool StampedVelodyne::FromCarmenLog(std::stringstream &ss)
+
+// read, segment and save the labeled range image
+bool StampedVelodyne::DecodeScan(SimpleLidarSegmentation &segm)
 {
+    // the range image and the cell of each point
+    VelodyneRangeImage image;
+    std::vector<uint32_t> cells;
+
     // the pcl object
-    PointCloudHSV::Ptr input_cloud = 1e04 > StringHelper::GetStringStreamSize(ss) ? ReadVelodyneCloudFromFile(ss) : ReadVelodyneCloudFromLog(ss);
+    PointCloudHSV::Ptr input_cloud = raw_scan.empty() ? ReadVelodyneCloudFromFile(image, cells) : ReadVelodyneCloudFromLog(image, cells);
+
+    // release the raw scan
+    std::string().swap(raw_scan);
 
     if (0 < input_cloud->size())
     {
-        // creates the filtered version
-        PointCloudHSV::Ptr filtered_cloud(new PointCloudHSV());
-
         // remove undesired points
-        StampedLidar::RemoveUndesiredPoints(*input_cloud);
+        StampedLidar::RemoveUndesiredPoints(segm, *input_cloud);
+
+        // the segmentation paints the tall and ground points, the undesired ones keep the azimuth value
+        for (unsigned k = 0; k < input_cloud->size(); ++k)
+        {
+            // the current hue
+            float h = input_cloud->points[k].h;
 
-        // filtering the input point cloud
-        StampedLidar::grid_filtering.setInputCloud(input_cloud);
+            image.labels[cells[k]] = 96.0f == h ? RANGE_IMAGE_TALL : (23.0f == h ? RANGE_IMAGE_GROUND : RANGE_IMAGE_EMPTY);
+        }
 
-        // get the resulting filtered version
-        StampedLidar::grid_filtering.filter(*filtered_cloud);
+        // the place recognition descriptor
+        StampedLidar::descriptor.Build(*input_cloud);
 
-        // set the filename
-        std::stringstream pcd_filename;
-        pcd_filename << StampedMessage::id << ".pcd";
+        // the overlap footprint, only the tall structure is useful to the registration
+        StampedLidar::footprint.Build(*input_cloud, true);
 
-        // update the path name
-        StampedLidar::path += pcd_filename.str();
+        // the packed range image
+        std::vector<char> packed(image.PackedSize());
+        image.Pack(packed.data());
 
-        // save the input cloud, binary option set to true
-        if (-1 == pcl::io::savePCDFile(StampedLidar::path, *filtered_cloud, true))
+        // append the range image to the packed store, the message keeps the slot
+        if (!StampedLidar::cloud_store->Append(packed.data(), packed.size(), StampedLidar::cloud_slot))
         {
             // show the error
             std::cerr << "Could not save the input cloud, verify the tmp/velodyne/ directory\n";
 
             return false;
         }
-
-        // clear the filtered cloud
-        filtered_cloud->clear();
     }
 
     // clear the input cloud
@@ -309,6 +486,84 @@ bool StampedVelodyne::FromCarmenLog(std::stringstream &ss)
 }
 
 
+// expand the range image to a voxel filtered cloud
+bool StampedVelodyne::LoadCloud(PointCloudHSV &cloud) const
+{
+    // the packed range image
+    const char *packed = nullptr;
+    std::size_t size = 0;
+
+    // the unpacked version
+    VelodyneRangeImage image;
+
+    if (!StampedLidar::cloud_store->Get(StampedLidar::cloud_slot, packed, size) || !image.Unpack(packed, size))
+    {
+        return false;
+    }
+
+    // the vertical angles
+    const LaserTable &lasers(image.from_log ? log_lasers : file_lasers);
+
+    // the expanded cloud
+    PointCloudHSV::Ptr expanded(new PointCloudHSV());
+    expanded->points.reserve(image.ranges.size());
+
+    for (unsigned i = 0; i < image.Columns(); ++i)
+    {
+        // the column azimuth
+        float phi = image.azimuth[i];
+        float sin_phi = float(std::sin(double(phi)));
+        float cos_phi = float(std::cos(double(phi)));
+
+        for (unsigned j = 0; j < 32; ++j)
+        {
+            // the current cell
+            unsigned cell = 32 * i + j;
+
+            if (RANGE_IMAGE_EMPTY != image.labels[cell])
+            {
+                // the distance value
+                float distance = float(image.ranges[cell]) * image.range_scale;
+
+                // the new point
+                pcl::PointXYZHSV point;
+
+                // get the rectangular coordinates
+                float rsin = distance * lasers.sin_theta[j];
+
+                point.x = rsin * cos_phi;
+                point.y = rsin * sin_phi;
+                point.z = distance * lasers.cos_theta[j];
+
+                // the segmentation colors
+                point.h = RANGE_IMAGE_TALL == image.labels[cell] ? 96.0f : 23.0f;
+                point.s = 1.0f;
+                point.v = 0.5f;
+
+                expanded->points.push_back(point);
+            }
+        }
+    }
+
+    expanded->width = expanded->points.size();
+    expanded->height = 1;
+
+    // the cloud filtering object
+    VoxelGridFilter grid_filtering;
+
+    // set the default leaf size
+    grid_filtering.setLeafSize(StampedLidar::vg_leaf, StampedLidar::vg_leaf, StampedLidar::vg_leaf);
+
+    // filtering the expanded point cloud
+    grid_filtering.setInputCloud(expanded);
+
+    // get the resulting filtered version
+    grid_filtering.filter(cloud);
+
+    return true;
+}
+
+
 // get the message type
 StampedMessageType StampedVelodyne::GetType()
 {
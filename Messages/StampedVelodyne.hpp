@@ -2,6 +2,7 @@
 #define HYPERGRAPHSLAM_STAMPED_VELODYNE_HPP
 
 #include <StampedLidar.hpp>
+#include <VelodyneRangeImage.hpp>
 
 namespace hyper {
 
@@ -9,9 +10,6 @@ namespace hyper {
     {
         protected:
 
-            // the default velodyne file path
-            static const std::string base_velodyne_path;
-
             // the vertical correction values
             static const double vertical_correction[32];
 
@@ -30,14 +28,69 @@ namespace hyper {
             // the struct size
             static const unsigned velodyne_struct_size;
 
-            // read the point cloud from file
-            PointCloudHSV::Ptr ReadVelodyneCloudFromFile(std::stringstream &ss);
+            // the laser angles in float precision, one entry per laser
+            struct LaserTable
+            {
+                // the vertical angles
+                float theta[32];
+
+                // the precomputed sines and cosines
+                float sin_theta[32];
+                float cos_theta[32];
+            };
+
+            // the cloud limits, in float precision
+            struct CloudBounds
+            {
+                float minx, maxx, miny, maxy, minz, maxz;
+            };
+
+            // the vertical angles used by the binary scan files
+            static const LaserTable file_lasers;
+
+            // the vertical angles used by the in-log scans
+            static const LaserTable log_lasers;
+
+            // how many encoder positions in the in-log scans, hundredths of degree
+            static const unsigned azimuth_steps;
+
+            // build the laser table, the in-log scans use the complementary vertical angles
+            static LaserTable BuildLaserTable(bool from_log);
+
+            // the cached in-log azimuth sines and cosines, interleaved and built only once
+            static const std::vector<float>& AzimuthTable();
+
+            // convert a column of 32 ranges sharing the same azimuth, only the valid points are written to the output buffer
+            // the range image cell of each point is written to the cells buffer
+            // it updates the bounds and returns how many points were written
+            static unsigned ConvertColumn(
+                const LaserTable &lasers, float phi, float sin_phi, float cos_phi,
+                const float *distances, uint32_t first_cell, pcl::PointXYZHSV *output, uint32_t *cells, CloudBounds &bounds);
 
-            // read the point cloud from carmen log
-            PointCloudHSV::Ptr ReadVelodyneCloudFromLog(std::stringstream &ss);
+            // update the min, max and abs values
+            void SetBounds(const CloudBounds &bounds);
+
+            // the binary scan file, for the VELODYNE_PARTIAL_SCAN_IN_FILE messages
+            std::string scan_path;
+
+            // the raw scan copied from the log, for the VELODYNE_PARTIAL_SCAN messages
+            // it's released after the decoding
+            std::string raw_scan;
+
+            // read the point cloud from file, it also fills the range image and the point cells
+            PointCloudHSV::Ptr ReadVelodyneCloudFromFile(VelodyneRangeImage &image, std::vector<uint32_t> &cells);
+
+            // read the point cloud from carmen log, it also fills the range image and the point cells
+            PointCloudHSV::Ptr ReadVelodyneCloudFromLog(VelodyneRangeImage &image, std::vector<uint32_t> &cells);
 
         public:
 
+            // the velodyne cloud store file, relative to the scratch directory
+            static const std::string base_velodyne_path;
+
+            // the packed velodyne clouds
+            static PackedCloudStore cloud_store;
+
             // how many vertical scans
             unsigned vertical_scans;
 
@@ -47,8 +100,16 @@ namespace hyper {
             // the basic destructor
             virtual ~StampedVelodyne();
 
-            // parse the pose from string stream
-            virtual bool FromCarmenLog(std::stringstream &ss);
+            // parse the pose from the log tokens
+            // it only tokenizes the message, the scan is decoded later by DecodeScan
+            virtual bool FromCarmenLog(LogTokenizer &tokens);
+
+            // read, segment and save the labeled range image
+            // the segmentation object is not thread safe, so each decoder thread has its own
+            bool DecodeScan(SimpleLidarSegmentation &segm);
+
+            // expand the range image to a voxel filtered cloud
+            virtual bool LoadCloud(PointCloudHSV &cloud) const;
 
             // get the message type
             virtual StampedMessageType GetType();
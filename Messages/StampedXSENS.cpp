@@ -36,26 +36,29 @@ double StampedXSENS::GetYawFromQuaternion(double w, double x, double y, double z
 
 // PUBLIC METHODS
 
-// parse the pose from string stream
-bool StampedXSENS::FromCarmenLog(std::stringstream &ss)
+// parse the pose from the log tokens
+bool StampedXSENS::FromCarmenLog(LogTokenizer &tokens)
 {
     // the quaternion values
-    double w, x, y, z;
+    double w = 1.0, x = 0.0, y = 0.0, z = 0.0;
 
     // discards the first three values
-    SkipValues(ss, 3);
+    tokens.Skip(3);
 
     // get the four quaternions values
-    ss >> w >> x >> y >> z;
+    tokens.Read(w);
+    tokens.Read(x);
+    tokens.Read(y);
+    tokens.Read(z);
 
     // convert the quaternion to yaw
     yaw = GetYawFromQuaternion(w, x, y, z);
 
     // discards the next eight values
-    SkipValues(ss, 8);
+    tokens.Skip(8);
 
     // get the message timestamp
-    ss >> StampedMessage::timestamp;
+    tokens.Read(StampedMessage::timestamp);
 
     return true;
 }
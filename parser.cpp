@@ -2,24 +2,7 @@
 #include <unistd.h>
 #include <GrabData.hpp>
 #include <StampedGPSPose.hpp>
-#include <boost/filesystem/operations.hpp>
-
-void
-prepare_all_directories()
-{
-    // remove the directory contents recursively, and then removes the directory.
-    boost::filesystem::remove_all("/dados/tmp");
-
-    boost::filesystem::create_directory("/dados/tmp");
-    boost::filesystem::create_directory("/dados/tmp/sick");
-    boost::filesystem::create_directory("/dados/tmp/velodyne");
-    boost::filesystem::create_directory("/dados/tmp/lgm");
-    boost::filesystem::create_directory("/dados/tmp/lgm/sick");
-    boost::filesystem::create_directory("/dados/tmp/lgm/velodyne");
-    boost::filesystem::create_directory("/dados/tmp/images");
-
-    std::cout << "Necessary directories created." << std::endl;
-}
+#include <ScratchStorage.hpp>
 
 
 int 
@@ -32,8 +15,6 @@ main (int argc, char **argv)
         return -1;
     }
 
-    prepare_all_directories();
-
     // read the input filenames
     std::string input_file(argv[1]);
     std::string output_file(argv[2]);
@@ -48,6 +29,12 @@ main (int argc, char **argv)
     // configure it
     gd.Configure(config_filename, carmen_ini);
 
+    // the configured scratch directory
+    if (!hyper::ScratchStorage::Prepare())
+    {
+        return -1;
+    }
+
     // try to process the log file
     if (gd.ParseLogFile(input_file)) 
     {
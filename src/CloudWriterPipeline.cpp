@@ -0,0 +1,109 @@
+#include <CloudWriterPipeline.hpp>
+
+#include <pcl/common/transforms.h>
+
+using namespace hyper;
+
+// the basic constructor
+CloudWriterPipeline::CloudWriterPipeline() :
+    queue(CLOUD_WRITER_QUEUE_SIZE),
+    writer(),
+    compressed(false),
+    drop_when_full(false),
+    dropped(0),
+    error(nullptr) {}
+
+// the basic destructor
+CloudWriterPipeline::~CloudWriterPipeline()
+{
+    Stop();
+}
+
+// the writer thread loop
+void CloudWriterPipeline::Write()
+{
+    // the current snapshot
+    CloudSnapshot snapshot;
+
+    // the transformed cloud
+    PointCloudHSV transformed;
+
+    while (queue.Pop(snapshot))
+    {
+        // after an error, keep emptying the queue so the icp threads never block
+        if (nullptr != error)
+        {
+            continue;
+        }
+
+        try
+        {
+            pcl::transformPointCloud(*snapshot.cloud, transformed, Eigen::Matrix4f(snapshot.transformation));
+
+            StampedLidar::SavePointCloud(snapshot.base_path, snapshot.cloud_id, transformed, compressed);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+    }
+}
+
+// start the writer thread
+void CloudWriterPipeline::Start(unsigned queue_size, bool _compressed, bool _drop_when_full)
+{
+    // an aborted run may have left the old writer running
+    Stop();
+
+    queue.Reset(queue_size);
+
+    compressed = _compressed;
+    drop_when_full = _drop_when_full;
+    dropped = 0;
+    error = nullptr;
+
+    writer = std::thread(&CloudWriterPipeline::Write, this);
+}
+
+// copy the cloud and push the snapshot
+void CloudWriterPipeline::Push(const std::string &base_path, unsigned cloud_id, const PointCloudHSV &cloud, const Eigen::Matrix4f &transformation)
+{
+    CloudSnapshot snapshot { base_path, cloud_id, PointCloudHSV::Ptr(new PointCloudHSV(cloud)), transformation };
+
+    if (drop_when_full)
+    {
+        if (!queue.TryPush(snapshot))
+        {
+            ++dropped;
+        }
+    }
+    else
+    {
+        queue.Push(snapshot);
+    }
+}
+
+// close the queue and join the writer thread
+void CloudWriterPipeline::Stop()
+{
+    queue.Close();
+
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+}
+
+// wait all the queued snapshots
+unsigned CloudWriterPipeline::Finish()
+{
+    // the writer quits after the last snapshot
+    Stop();
+
+    if (nullptr != error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    return dropped;
+}
@@ -0,0 +1,89 @@
+#ifndef HYPERGRAPHSLAM_CLOUD_WRITER_PIPELINE_HPP
+#define HYPERGRAPHSLAM_CLOUD_WRITER_PIPELINE_HPP
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+#include <Eigen/Core>
+
+#include <StampedLidar.hpp>
+#include <BoundedQueue.hpp>
+
+namespace hyper {
+
+#define CLOUD_WRITER_QUEUE_SIZE 32
+
+    // an accumulated cloud waiting to be saved
+    struct CloudSnapshot
+    {
+        // the output directory and the cloud number
+        std::string base_path;
+        unsigned cloud_id;
+
+        // our own copy of the cloud
+        PointCloudHSV::Ptr cloud;
+
+        // applied by the writer before saving, unaligned so the snapshot can live in the queue
+        Eigen::Matrix<float, 4, 4, Eigen::DontAlign> transformation;
+    };
+
+    // the icp threads only copy the accumulated clouds and push them here
+    // a dedicated writer thread transforms and saves the clouds
+    class CloudWriterPipeline
+    {
+        private:
+
+            // the cloud snapshots
+            BoundedQueue<CloudSnapshot> queue;
+
+            // the writer thread
+            std::thread writer;
+
+            // save the compressed binary pcd format
+            bool compressed;
+
+            // drop the snapshots instead of blocking the icp threads when the queue is full
+            bool drop_when_full;
+
+            // how many snapshots were dropped
+            std::atomic<unsigned> dropped;
+
+            // the first exception thrown by the writer thread
+            std::exception_ptr error;
+
+            // the writer thread loop
+            void Write();
+
+            // removing the copy constructor
+            CloudWriterPipeline(const CloudWriterPipeline&) = delete;
+
+            // removing the assignment operator overloading
+            void operator=(const CloudWriterPipeline&) = delete;
+
+        public:
+
+            // the basic constructor
+            CloudWriterPipeline();
+
+            // the basic destructor
+            ~CloudWriterPipeline();
+
+            // start the writer thread, at most queue_size snapshots wait in the queue
+            void Start(unsigned queue_size, bool _compressed, bool _drop_when_full);
+
+            // copy the cloud and push the snapshot, it blocks while the queue is full unless the snapshots can be dropped
+            void Push(const std::string &base_path, unsigned cloud_id, const PointCloudHSV &cloud, const Eigen::Matrix4f &transformation);
+
+            // close the queue and join the writer thread, it never throws
+            void Stop();
+
+            // wait all the queued snapshots, it rethrows the writer exception
+            // returns how many snapshots were dropped
+            unsigned Finish();
+    };
+
+}
+
+#endif
@@ -2,10 +2,12 @@
 #include <StampedMessageType.hpp>
 
 #include <list>
+#include <algorithm>
 #include <cmath>
 #include <thread>
 #include <iterator>
 #include <stdexcept>
+#include <exception>
 #include <utility>
 #include <limits>
 #include <unistd.h>
@@ -17,8 +19,16 @@ using namespace hyper;
 
 // the main constructor
 GrabData::GrabData() :
+    xsens_pool(),
+    odometry_pool(),
+    gps_pose_pool(),
+    gps_orientation_pool(),
+    sick_pool(),
+    bumblebee_pool(),
+    velodyne_pool(),
     raw_messages(0),
     messages(0),
+    message_store(),
     gps_messages(0),
     xsens_messages(0),
     velodyne_messages(0),
@@ -31,17 +41,37 @@ GrabData::GrabData() :
     gps_origin(0.0, 0.0),
     icp_start_index(0),
     icp_end_index(0),
+    loop_candidate_index(0),
     icp_mutex(),
-    first_last_mutex(),
     error_increment_mutex(),
     icp_errors(0),
+    velodyne_decoder(),
+    cloud_writer(),
+    cloud_cache(),
     dmax(std::numeric_limits<double>::max()),
     maximum_vel_scans(MAXIMUM_VEL_SCANS),
     loop_required_time(LOOP_REQUIRED_TIME),
     loop_required_distance(LOOP_REQUIRED_DISTANCE),
+    loop_closure_spacing(LOOP_CLOSURE_SPACING),
+    loop_descriptor_top_k(LOOP_DESCRIPTOR_TOP_K),
+    loop_descriptor_search_distance(LOOP_DESCRIPTOR_SEARCH_DISTANCE),
+    loop_descriptor_max_distance(LOOP_DESCRIPTOR_MAX_DISTANCE),
+    use_vgicp(false),
+    vgicp_resolution(VGICP_RESOLUTION),
+    vgicp_threads(1),
+    use_planar_velodyne_odometry(false),
+    use_planar_velodyne_loop(false),
+    use_ground_leveling(false),
+    registration_pyramid(0),
     icp_threads_pool_size(ICP_THREADS_POOL_SIZE),
     icp_thread_block_size(ICP_THREAD_BLOCK_SIZE),
+    icp_thread_block_distance(ICP_THREAD_BLOCK_DISTANCE),
     lidar_odometry_min_distance(LIDAR_ODOMETRY_MIN_DISTANCE),
+    lidar_keyframe_distance(LIDAR_KEYFRAME_DISTANCE),
+    lidar_keyframe_yaw(LIDAR_KEYFRAME_YAW),
+    lidar_keyframe_min_overlap(LIDAR_KEYFRAME_MIN_OVERLAP),
+    lidar_keyframe_max_step(LIDAR_KEYFRAME_MAX_STEP),
+    local_map_radius(LOCAL_MAP_RADIUS),
     visual_odometry_min_distance(VISUAL_ODOMETRY_MIN_DISTANCE),
     icp_translation_confidence_factor(ICP_TRANSLATION_CONFIDENCE_FACTOR),
     save_accumulated_point_clouds(false),
@@ -51,7 +81,17 @@ GrabData::GrabData() :
     use_velodyne_loop(true),
     use_sick_loop(true),
     use_bumblebee_loop(true),
-    use_fake_gps(false) {}
+    use_fake_gps(false),
+    use_mmap_log_reader(true),
+    log_parser_threads(LOG_PARSER_THREADS),
+    velodyne_decoder_threads(VELODYNE_DECODER_THREADS),
+    velodyne_decoder_queue_size(VELODYNE_DECODER_QUEUE_SIZE),
+    cloud_writer_queue_size(CLOUD_WRITER_QUEUE_SIZE),
+    cloud_writer_compressed(false),
+    cloud_writer_drop_when_full(false),
+    cloud_cache_mb(CLOUD_CACHE_MB),
+    scratch_root(SCRATCH_ROOT),
+    use_in_memory_scratch(false) {}
 
 // the main destructor
 GrabData::~GrabData()
@@ -67,9 +107,12 @@ void GrabData::SeparateMessages()
 {
     // clear the gps, sick and velodyne list
     messages.clear();
+    message_store.Clear();
     gps_messages.clear();
+    xsens_messages.clear();
     sick_messages.clear();
     velodyne_messages.clear();
+    odometry_messages.clear();
     bumblebee_messages.clear();
 
     // helpers
@@ -88,14 +131,11 @@ void GrabData::SeparateMessages()
     // the odometry messages with invalid speed counter
     int zeros = max_zeros;
 
-    // try to downcast
     // find the first valid odometry value
     while (end != it)
     {
-        // try to downcast
-        StampedOdometryPtr odom = dynamic_cast<StampedOdometryPtr>(*it);
-
-        if (nullptr != odom && 0.001 < std::fabs(odom->v))
+        // check the type tag before the downcasting
+        if (StampedOdometryMessage == (*it)->GetType() && 0.001 < std::fabs(dynamic_cast<StampedOdometryPtr>(*it)->v))
         {
             break;
         }
@@ -106,8 +146,13 @@ void GrabData::SeparateMessages()
 
     while (end != it)
     {
-        // try the downcasting
-        StampedOdometryPtr odom = dynamic_cast<StampedOdometryPtr>(*it);
+        // direct access
+        StampedMessagePtr msg = *it;
+
+        // the type tag, a single downcast per message to the right type
+        StampedMessageType type = msg->GetType();
+
+        StampedOdometryPtr odom = StampedOdometryMessage == type ? dynamic_cast<StampedOdometryPtr>(msg) : nullptr;
 
         if (nullptr != odom)
         {
@@ -118,40 +163,42 @@ void GrabData::SeparateMessages()
 
         if (valid_velocity || 0 < zeros)
         {
-            // direct access
-            StampedMessagePtr msg = *it;
-
-            // try to downcast
-            StampedGPSPosePtr gps_pose = dynamic_cast<StampedGPSPosePtr>(msg);
-            StampedXSENSPtr xsens = dynamic_cast<StampedXSENSPtr>(msg);
-            StampedSICKPtr sick = dynamic_cast<StampedSICKPtr>(msg);
-            StampedVelodynePtr velodyne = dynamic_cast<StampedVelodynePtr>(msg);
-            StampedBumblebeePtr bumblebee = dynamic_cast<StampedBumblebeePtr>(msg);
-
-            if (nullptr != odom)
-            {
-                odometry_messages.push_back(odom);
-                zeros = valid_velocity ? max_zeros : zeros - 1;
-            }
-            else if (nullptr != gps_pose)
-            {
-                gps_messages.push_back(gps_pose);
-            }
-            else if (nullptr != xsens)
+            switch (type)
             {
-                xsens_messages.push_back(xsens);
-            }
-            else if (nullptr != sick)
-            {
-                sick_messages.push_back(static_cast<StampedLidarPtr>(sick));
-            }
-            else if (nullptr != velodyne)
-            {
-                velodyne_messages.push_back(static_cast<StampedLidarPtr>(velodyne));
-            }
-            else if (nullptr != bumblebee)
-            {
-                bumblebee_messages.push_back(bumblebee);
+                case StampedOdometryMessage:
+                    odometry_messages.push_back(odom);
+                    message_store.Push(odom);
+                    zeros = valid_velocity ? max_zeros : zeros - 1;
+                    break;
+
+                case StampedGPSMessage:
+                    gps_messages.push_back(dynamic_cast<StampedGPSPosePtr>(msg));
+                    message_store.Push(gps_messages.back());
+                    break;
+
+                case StampedGPSOrientationMessage:
+                    message_store.Push(dynamic_cast<StampedGPSOrientationPtr>(msg));
+                    break;
+
+                case StampedXsensMessage:
+                    message_store.Push(msg, type, xsens_messages.size());
+                    xsens_messages.push_back(dynamic_cast<StampedXSENSPtr>(msg));
+                    break;
+
+                case StampedSICKMessage:
+                    message_store.Push(msg, type, sick_messages.size());
+                    sick_messages.push_back(static_cast<StampedLidarPtr>(dynamic_cast<StampedSICKPtr>(msg)));
+                    break;
+
+                case StampedVelodyneMessage:
+                    message_store.Push(msg, type, velodyne_messages.size());
+                    velodyne_messages.push_back(static_cast<StampedLidarPtr>(dynamic_cast<StampedVelodynePtr>(msg)));
+                    break;
+
+                case StampedBumblebeeMessage:
+                    message_store.Push(msg, type, bumblebee_messages.size());
+                    bumblebee_messages.push_back(dynamic_cast<StampedBumblebeePtr>(msg));
+                    break;
             }
 
             // save to the the general messages
@@ -175,121 +222,35 @@ void GrabData::SeparateMessages()
 
 
 // get the gps estimation
-g2o::SE2 GrabData::GetNearestGPSMeasure(
-            StampedMessagePtrVector::iterator it,
-            StampedMessagePtrVector::iterator end,
-            int adv,
-            double timestamp,
-            double &dt)
+g2o::SE2 GrabData::GetGPSMeasure(double timestamp)
 {
+    // the nearest gps message
+    unsigned k = 0;
+    double dt = dmax;
 
-    g2o::SE2 gps_measurement(0.0, 0.0, 0.0);
-    dt = dmax;
-
-    // move the main iterator
-    std::advance(it, adv);
-
-    // iterate to the left messages
-    while (end != it)
+    if (message_store.gps_index.Nearest(timestamp, k, dt))
     {
-        // downcasting to gps orientation
-        StampedGPSPosePtr msg = dynamic_cast<StampedGPSPosePtr>(*it);
-
-        if (nullptr != msg)
-        {
-            // get the timestamp
-            dt = std::fabs(timestamp - msg->timestamp);
-
-            gps_measurement = msg->gps_measurement;
-
-            break;
-        }
-
-        // go to the left/right
-        std::advance(it, adv);
+        return message_store.gps_measurement[k];
     }
 
-    return gps_measurement;
+    return g2o::SE2(0.0, 0.0, 0.0);
 }
 
 
 // get the gps estimation
-g2o::SE2 GrabData::GetGPSMeasure(
-            StampedMessagePtrVector::iterator begin,
-            StampedMessagePtrVector::iterator gps,
-            StampedMessagePtrVector::iterator end,
-            double timestamp)
+Eigen::Rotation2Dd GrabData::GetGPSOrientation(double timestamp)
 {
+    // the nearest gps orientation message
+    unsigned k = 0;
+    double dt = dmax;
 
-    double ldt = 0.0, rdt = 0.0;
-
-    // iterate to the left
-    g2o::SE2 left(GetNearestGPSMeasure(gps, begin, -1, timestamp, ldt));
-
-    // iterate to the right
-    g2o::SE2 right(GetNearestGPSMeasure(gps, end, 1, timestamp, rdt));
-
-    // return the desired gps measurement
-    return ldt < rdt ? left : right;
-}
-
-
-// get the gps estimation
-void GrabData::GetNearestOrientation(
-            StampedMessagePtrVector::iterator it,
-            StampedMessagePtrVector::iterator end,
-            int adv,
-            double timestamp,
-            double &h,
-            double &dt)
-{
-    // move the main iterator
-    std::advance(it, adv);
+    // set the current heading
+    double yaw = 0.0;
 
-    // iterate to the left messages
-    while (end != it)
+    if (message_store.gps_yaw_index.Nearest(timestamp, k, dt))
     {
-        // downcasting to gps orientation
-        StampedGPSOrientationPtr gps_orientation = dynamic_cast<StampedGPSOrientationPtr>(*it);
-
-        if (nullptr != gps_orientation)
-        {
-            // get the heading info
-            h = mrpt::math::wrapToPi<double>(gps_orientation->yaw);
-
-            // get the timestamp
-            dt = std::fabs(timestamp - gps_orientation->timestamp);
-
-            break;
-        }
-
-        // go to the left/right
-        std::advance(it, adv);
+        yaw = message_store.gps_yaw[k];
     }
-}
-
-
-// get the gps estimation
-Eigen::Rotation2Dd GrabData::GetGPSOrientation(
-            StampedMessagePtrVector::iterator begin,
-            StampedMessagePtrVector::iterator gps,
-            StampedMessagePtrVector::iterator end,
-            double timestamp)
-{
-    // the left gps orientation and dt
-    double lh = 0.0, ldt = 0.0;
-
-    // the right gps orientation and dt
-    double rh = 0.0, rdt = 0.0;
-
-    // iterate to the left
-    GetNearestOrientation(gps, begin, -1, timestamp, lh, ldt);
-
-    // iterate to the right
-    GetNearestOrientation(gps, end, 1, timestamp, rh, rdt);
-
-    // set the current heading
-    double yaw = ldt < rdt ? lh : rh;
 
     // create the axis
     return Eigen::Rotation2Dd(mrpt::math::wrapToPi<double>(yaw));
@@ -318,26 +279,30 @@ void GrabData::BuildGPSMeasures()
     {
         std::cout << "Start building the GPS measurements and estimates\n";
 
-        StampedMessagePtrVector::iterator end(messages.end());
-        StampedMessagePtrVector::iterator begin(messages.begin());
-        StampedMessagePtrVector::iterator prev(messages.end());
-        StampedMessagePtrVector::iterator curr(messages.begin());
-        StampedMessagePtrVector::iterator next(messages.begin());
-        ++next;
+        // the columns
+        const std::vector<StampedMessageType> &types(message_store.types);
+        const std::vector<double> &timestamps(message_store.timestamps);
+        const std::vector<unsigned> &payload(message_store.payload);
+        std::vector<g2o::SE2> &gps_measurement(message_store.gps_measurement);
+
+        const unsigned size = message_store.Size();
 
         gps_origin = GetFirstGPSPosition();
         std::cout << "GPS ORIGIN: " << gps_origin.transpose() << std::endl;
 
-        while (end != curr)
+        for (unsigned curr = 0; curr < size; ++curr)
         {
-            StampedGPSPosePtr gps_pose = dynamic_cast<StampedGPSPosePtr>(*curr);
-
-            if (nullptr != gps_pose)
+            if (StampedGPSMessage == types[curr])
             {
-                gps_pose->gps_measurement.setTranslation(gps_pose->gps_measurement.translation() - gps_origin);
-                gps_pose->gps_measurement.setRotation(Eigen::Rotation2Dd(GetGPSOrientation(begin, curr, end, gps_pose->timestamp)));
+                // the gps column and the gps list share the same position
+                unsigned k = payload[curr];
+
+                gps_measurement[k].setTranslation(gps_measurement[k].translation() - gps_origin);
+                gps_measurement[k].setRotation(Eigen::Rotation2Dd(GetGPSOrientation(timestamps[curr])));
+
+                // keep the message updated
+                gps_messages[k]->gps_measurement = gps_measurement[k];
             }
-            ++curr;
         }
         std::cout << "GPS measurements and estimates were built successfully\n";
     }
@@ -388,6 +353,9 @@ void GrabData::BuildFakeGPSMeasures()
             ++curr;
         }
 
+        // update the gps column
+        message_store.GatherGPS(gps_messages);
+
         std::cout << "GPS measurements and estimates were built successfully\n";
     }
 }
@@ -406,111 +374,91 @@ void GrabData::BuildOdometryMeasures()
         double v = 0.0, phi = 0.0;
         double raw_v = 0.0, raw_phi = 0.0;
 
-        // iterators
-        StampedMessagePtrVector::iterator end(messages.end());
-        StampedMessagePtrVector::iterator begin(messages.begin());
-        StampedMessagePtrVector::iterator it(begin);
-
-        // find the first odometry message position
-        while (end != it)
-        {
-            // try to downcast the current message
-            StampedOdometryPtr odom = dynamic_cast<StampedOdometryPtr>(*it);
+        // the columns
+        const std::vector<StampedMessageType> &types(message_store.types);
+        const std::vector<double> &timestamps(message_store.timestamps);
+        const std::vector<unsigned> &payload(message_store.payload);
+        const std::vector<OdometryCommand> &odometry(message_store.odometry);
+        std::vector<g2o::SE2> &odom_measurement(message_store.odom_measurement);
+        std::vector<g2o::SE2> &raw_measurement(message_store.raw_measurement);
 
-            if (nullptr != odom)
-            {
-                // get the initial odometry values
-                v = odom->v;
-                phi = odom->phi;
-                raw_v = odom->raw_v;
-                phi = odom->raw_phi;
+        const unsigned size = message_store.Size();
 
-                // quit the loop
-                break;
-            }
+        // find the first odometry message position
+        unsigned first = 0;
 
+        while (size > first && StampedOdometryMessage != types[first])
+        {
             // go to the next message
-            ++it;
+            ++first;
         }
 
-        if (end != it)
+        if (size > first)
         {
+            // get the initial odometry values
+            const OdometryCommand &command(odometry[payload[first]]);
 
-            if (begin != it)
-            {
-                // iterators
-                StampedMessagePtrVector::reverse_iterator rend(messages.rend());
-                StampedMessagePtrVector::reverse_iterator rit(it + 1);
-                StampedMessagePtrVector::reverse_iterator prev(it);
+            v = command.v;
+            phi = command.phi;
+            raw_v = command.raw_v;
+            phi = command.raw_phi;
 
-                while (rend != prev)
+            // to the left, each message uses the next timestamp
+            for (unsigned prev = first; 0 < prev--;)
+            {
+                double dt = timestamps[prev + 1] - timestamps[prev];
+                if (dt > 0 && dt < 600)
                 {
-                   // get the internal message pointers
-                    StampedMessagePtr current_msg = *rit;
-                    StampedMessagePtr prev_msg = *prev;
-
-                    double dt = current_msg->timestamp - prev_msg->timestamp;
-                    if (dt > 0 && dt < 600)
-                    {
-                        // update the measurement
-                        prev_msg->odom_measurement = VehicleModel::GetOdometryMeasure(v, phi, dt);
-                        prev_msg->raw_measurement = VehicleModel::GetOdometryMeasure(raw_v, raw_phi, dt);
-                    }
-
-                    // go to the previous message
-                    rit = prev;
-                    ++prev;
+                    // update the measurement
+                    odom_measurement[prev] = VehicleModel::GetOdometryMeasure(v, phi, dt);
+                    raw_measurement[prev] = VehicleModel::GetOdometryMeasure(raw_v, raw_phi, dt);
                 }
             }
 
-            // get the next iterator
-            StampedMessagePtrVector::iterator next(it + 1);
-
-            while (end != next)
+            // to the right
+            for (unsigned curr = first, next = first + 1; size > next; curr = next++)
             {
-                // get the internal pointers
-                StampedMessagePtr current_msg = *it;
-                StampedMessagePtr next_msg = *next;
-
-                // try to downcast the current message to the odometry one
-                StampedOdometryPtr odom = dynamic_cast<StampedOdometryPtr>(current_msg);
-                if (nullptr != odom)
-                {
-                    // update the odometry values
-                    v = odom->v;
-                    phi = odom->phi;
-                    raw_v = odom->raw_v;
-                    raw_phi = odom->raw_phi;
-                }
-                else
+                switch (types[curr])
                 {
-                    // save the v value inside the lidar and bumblebee messages
-                    StampedLidarPtr lidar = dynamic_cast<StampedLidarPtr>(current_msg);
-                    StampedBumblebeePtr bumblebee = dynamic_cast<StampedBumblebeePtr>(current_msg);
-
-                    if (nullptr != lidar)
+                    case StampedOdometryMessage:
                     {
-                        lidar->speed = v;
-                    }
-                    else if (nullptr != bumblebee)
-                    {
-                        bumblebee->speed = v;
+                        // update the odometry values
+                        const OdometryCommand &current_command(odometry[payload[curr]]);
+
+                        v = current_command.v;
+                        phi = current_command.phi;
+                        raw_v = current_command.raw_v;
+                        raw_phi = current_command.raw_phi;
+
+                        break;
                     }
+
+                    // save the v value inside the lidar and bumblebee messages
+                    case StampedVelodyneMessage:
+                        velodyne_messages[payload[curr]]->speed = v;
+                        break;
+
+                    case StampedSICKMessage:
+                        sick_messages[payload[curr]]->speed = v;
+                        break;
+
+                    case StampedBumblebeeMessage:
+                        bumblebee_messages[payload[curr]]->speed = v;
+                        break;
+
+                    default:
+                        break;
                 }
 
                 // precompute the delta tim
-                double dt = next_msg->timestamp - current_msg->timestamp;
+                double dt = timestamps[next] - timestamps[curr];
 
                 if (dt > 0 && dt < 600)
                 {
                     // get the current odometry measurement
-                    current_msg->odom_measurement = VehicleModel::GetOdometryMeasure(v, phi, dt);
-                    current_msg->raw_measurement = VehicleModel::GetOdometryMeasure(raw_v, raw_phi, dt);
+                    odom_measurement[curr] = VehicleModel::GetOdometryMeasure(v, phi, dt);
+                    raw_measurement[curr] = VehicleModel::GetOdometryMeasure(raw_v, raw_phi, dt);
                 }
-
-                // go to the next messages
-                it = next;
-                ++next;
             }
         }
 
@@ -528,87 +476,65 @@ void GrabData::BuildOdometryEstimates(bool gps_based)
         // status reporting
         std::cout << "Start building the general estimates\n";
 
-        // helpers
-        StampedMessagePtrVector::iterator end(messages.end());
-        StampedMessagePtrVector::iterator it(messages.begin());
+        // the columns
+        const std::vector<StampedMessageType> &types(message_store.types);
+        const std::vector<unsigned> &payload(message_store.payload);
+        const std::vector<g2o::SE2> &gps_measurement(message_store.gps_measurement);
+        const std::vector<g2o::SE2> &odom_measurement(message_store.odom_measurement);
+        const std::vector<g2o::SE2> &raw_measurement(message_store.raw_measurement);
+        std::vector<g2o::SE2> &est(message_store.est);
+        std::vector<g2o::SE2> &raw_est(message_store.raw_est);
 
-        StampedGPSPosePtr first_gps_pose = nullptr;
+        const unsigned size = message_store.Size();
 
         // forward to the first gps pose
-        while (end != it)
-        {
-            // try to downcast
-            first_gps_pose = dynamic_cast<StampedGPSPosePtr>(*it);
-
-            if (nullptr != first_gps_pose)
-            {
-                // set the first gps pose estimate
-                first_gps_pose->est = first_gps_pose->gps_measurement;
-                first_gps_pose->raw_est = first_gps_pose->gps_measurement;
-                break;
-            }
+        unsigned first = 0;
 
+        while (size > first && StampedGPSMessage != types[first])
+        {
             // go to the next message
-            ++it;
+            ++first;
         }
 
-        if (end != it && messages.begin() != it)
+        if (size > first)
         {
-            // iterate to the left
-            StampedMessagePtrVector::reverse_iterator rend(messages.rend());
-            StampedMessagePtrVector::reverse_iterator rb(it + 1);
-            StampedMessagePtrVector::reverse_iterator ra(it);
+            // set the first gps pose estimate
+            est[first] = gps_measurement[payload[first]];
+            raw_est[first] = gps_measurement[payload[first]];
 
             // update the previous estimates
             // to the left
-            while (rend != ra)
+            for (unsigned prev = first; 0 < prev--;)
             {
-                StampedMessagePtr current = *rb;
-                StampedMessagePtr previous = *ra;
-
-                previous->est = current->est * (previous->odom_measurement.inverse());
-                previous->raw_est = current->raw_est * (previous->raw_measurement.inverse());
-
-                rb = ra;
-                ++ra;
+                est[prev] = est[prev + 1] * (odom_measurement[prev].inverse());
+                raw_est[prev] = raw_est[prev + 1] * (raw_measurement[prev].inverse());
             }
         }
         else
         {
-            // reset the iterator
-            it = messages.begin();
+            // reset the index
+            first = 0;
         }
 
-        // forward iterators
-        StampedMessagePtrVector::iterator a(it);
-        StampedMessagePtrVector::iterator b(it + 1);
-
         // to the right
-        while (end != b)
+        for (unsigned curr = first, next = first + 1; size > next; curr = next++)
         {
-            // direct access
-            StampedMessagePtr current = *a;
-            StampedMessagePtr next = *b;
-
-            StampedGPSPosePtr m_gps = dynamic_cast<StampedGPSPosePtr>(next);
-
-            if (gps_based && nullptr != m_gps)
+            if (gps_based && StampedGPSMessage == types[next])
             {
-                next->est = m_gps->gps_measurement;
-                next->raw_est = m_gps->gps_measurement;
+                est[next] = gps_measurement[payload[next]];
+                raw_est[next] = gps_measurement[payload[next]];
             }
             else
             {
                 // set the initial estimate
-                next->est = current->est * (current->odom_measurement);
-                next->raw_est = current->raw_est * (current->raw_measurement);
+                est[next] = est[curr] * (odom_measurement[curr]);
+                raw_est[next] = raw_est[curr] * (raw_measurement[curr]);
             }
-
-            // go to the next messages
-            a = b;
-            ++b;
         }
 
+        // the lidar and visual odometry methods read the estimates from the messages
+        message_store.Scatter();
+
         // status report
         std::cout << "General estimates done!\n";
     }
@@ -622,35 +548,35 @@ void GrabData::BuildOdometryEstimates(bool gps_based)
 // build an icp measurement
 bool GrabData::BuildLidarOdometryMeasure(
         GeneralizedICP &gicp,
-        VoxelGridFilter &grid_filtering,
+        VoxelizedGICP &vgicp,
         double cf,
         const g2o::SE2 &odom,
-        PointCloudHSV::Ptr source_cloud,
-        PointCloudHSV::Ptr target_cloud,
+        LocalVoxelMap &local_map,
+        StampedLidarPtr target,
+        PointCloudHSV::ConstPtr target_cloud,
+        CloudFeatures::ConstPtr target_features,
         g2o::SE2 &icp_measurement )
 {
-    // the resulting aligned point cloud
-    PointCloudHSV result;
-
-    // unset the dense flags
-    source_cloud->is_dense = false;
-    target_cloud->is_dense = false;
+    // gicp can't build the covariances of a small cloud
+    if (nullptr == target_features)
+    {
+        std::cout << "Error: the target cloud is too small!" << std::endl;
 
-    // set the new correspondence factor
-    gicp.setMaxCorrespondenceDistance(std::fabs(cf));
+        return false;
+    }
 
-    // inverting the target and source
-    gicp.setInputSource(target_cloud);
-    gicp.setInputTarget(source_cloud);
+    // the current scan pose inside the local map
+    Eigen::Matrix4f current_pose(local_map.Pose());
 
-    // perform the icp method
-    // gicp.align(result);
-    gicp.align(result, BuildEigenMatrixFromSE2(odom));
+    // the final transformation and the fitness score
+    Eigen::Matrix4f next_pose;
+    double fitness;
 
-    if (gicp.hasConverged())
+    // inverting the target and source, the local map features are computed by the registration method
+    if (AlignClouds(gicp, vgicp, cf, target, target_cloud, target_features, nullptr, local_map.Cloud(), CloudFeatures::ConstPtr(), current_pose * BuildEigenMatrixFromSE2(odom), next_pose, fitness))
     {
-        // get the final transformation
-        Eigen::Matrix4f icp_guess(gicp.getFinalTransformation());
+        // the transformation between the current and next scans
+        Eigen::Matrix4f icp_guess(current_pose.inverse() * next_pose);
 
         // get the desired transformation
         icp_measurement = GetSE2FromEigenMatrix(icp_guess);
@@ -664,26 +590,8 @@ bool GrabData::BuildLidarOdometryMeasure(
         // the movement and the cf value should have the same sign
         if (valid_transformation)
         {
-            // get the inverse transformation
-            Eigen::Matrix4f icp_inverse(icp_guess.inverse());
-
-            // the transformed point cloud
-            pcl::PointCloud<pcl::PointXYZHSV>::Ptr transformed_cloud(new pcl::PointCloud<pcl::PointXYZHSV>());
-
-            // transform the cloud
-            pcl::transformPointCloud(*source_cloud, *transformed_cloud, icp_inverse);
-
-            // clear the entire source cloud
-            source_cloud->clear();
-
-            // accumulate the clouds
-            *transformed_cloud += *target_cloud;
-
-            // filtering process
-            grid_filtering.setInputCloud(transformed_cloud);
-
-            // filtering process!
-            grid_filtering.filter(*source_cloud);
+            // insert the next scan in place, the old voxels out of the radius are evicted
+            local_map.Insert(*target_cloud, next_pose);
 
             // success
             return true;
@@ -708,83 +616,306 @@ bool GrabData::BuildLidarOdometryMeasure(
 // build an icp measurement
 bool GrabData::BuildLidarLoopMeasure(
         GeneralizedICP &gicp,
+        VoxelizedGICP &vgicp,
         double cf,
-        PointCloudHSV::Ptr source_cloud,
-        PointCloudHSV::Ptr target_cloud,
-        g2o::SE2 &loop_measurement)
+        StampedLidarPtr source,
+        StampedLidarPtr target,
+        PointCloudHSV::ConstPtr source_cloud,
+        PointCloudHSV::ConstPtr target_cloud,
+        CloudFeatures::ConstPtr source_features,
+        CloudFeatures::ConstPtr target_features,
+        const g2o::SE2 &guess,
+        g2o::SE2 &loop_measurement,
+        double &fitness)
 {
+    // gicp can't build the covariances of a small cloud
+    if (nullptr == source_features || nullptr == target_features)
+    {
+        return false;
+    }
+
+    // the final transformation
+    Eigen::Matrix4f transformation;
+
+    // inverting the target and source, both clouds are cached so the trees and covariances are reused
+    if (AlignClouds(gicp, vgicp, cf, target, target_cloud, target_features, source, source_cloud, source_features, BuildEigenMatrixFromSE2(guess), transformation, fitness))
+    {
+        // get the desired transformation
+        loop_measurement = GetSE2FromEigenMatrix(transformation);
+
+        return true;
+    }
+
+    // invalid
+    return false;
+}
+
+
+// a single registration level
+bool GrabData::AlignLevel(
+        GeneralizedICP &gicp,
+        VoxelizedGICP &vgicp,
+        double cf,
+        unsigned max_iterations,
+        PointCloudHSV::ConstPtr source_cloud,
+        CloudFeatures::ConstPtr source_features,
+        PointCloudHSV::ConstPtr target_cloud,
+        CloudFeatures::ConstPtr target_features,
+        const Eigen::Matrix4f &guess,
+        Eigen::Matrix4f &transformation,
+        double &fitness)
+{
+    // the pcl gicp solves the full 6 dof problem, so the planar mode always runs on the voxelized gicp
+    if (use_vgicp || vgicp.IsPlanar())
+    {
+        // the source covariances come from the cache, the target becomes a voxel hash
+        if (!vgicp.SetSource(*source_cloud, *source_features->covariances) ||
+            !vgicp.SetTarget(*target_cloud, nullptr != target_features ? target_features->covariances.get() : nullptr))
+        {
+            return false;
+        }
+
+        vgicp.SetMaxIterations(max_iterations);
+
+        if (vgicp.Align(guess))
+        {
+            transformation = vgicp.FinalTransformation();
+            fitness = vgicp.FitnessScore();
+
+            return true;
+        }
+
+        return false;
+    }
+
     // the resulting aligned point cloud
     PointCloudHSV result;
 
-    // unset the dense flags
-    source_cloud->is_dense = false;
-    target_cloud->is_dense = false;
-
-    // set the new correspondence factor
+    // set the new correspondence factor and the level iterations
     gicp.setMaxCorrespondenceDistance(std::fabs(cf));
+    gicp.setMaximumIterations(max_iterations);
 
-    // inverting the target and source
-    gicp.setInputSource(target_cloud);
-    gicp.setInputTarget(source_cloud);
+    gicp.setInputSource(source_cloud);
+    gicp.setInputTarget(target_cloud);
 
-    // perform the icp method
-    gicp.align(result);
+    // the cached cloud features
+    gicp.setSearchMethodSource(source_features->tree, true);
+    gicp.setSourceCovariances(source_features->covariances);
+
+    if (nullptr != target_features)
+    {
+        gicp.setSearchMethodTarget(target_features->tree, true);
+        gicp.setTargetCovariances(target_features->covariances);
+    }
+
+    // perform the icp method, starting from the given guess
+    gicp.align(result, guess);
 
     if (gicp.hasConverged())
     {
-        // get the desired transformation
-        loop_measurement = GetSE2FromEigenMatrix(gicp.getFinalTransformation());
+        transformation = gicp.getFinalTransformation();
+        fitness = gicp.getFitnessScore();
 
         return true;
     }
 
-    // invalid
     return false;
 }
 
 
-// get the next lidar block
-bool GrabData::GetNextLidarBlock(unsigned &first_index, unsigned &last_index)
+// align the source cloud to the target cloud with the selected registration method
+bool GrabData::AlignClouds(
+        GeneralizedICP &gicp,
+        VoxelizedGICP &vgicp,
+        double cf,
+        StampedLidarPtr source,
+        PointCloudHSV::ConstPtr source_cloud,
+        CloudFeatures::ConstPtr source_features,
+        StampedLidarPtr target,
+        PointCloudHSV::ConstPtr target_cloud,
+        CloudFeatures::ConstPtr target_features,
+        const Eigen::Matrix4f &guess,
+        Eigen::Matrix4f &transformation,
+        double &fitness)
 {
-    // the status
-    bool status = false;
+    // the current guess, each level seeds the next one
+    Eigen::Matrix4f current_guess(guess);
 
-    // lock the mutex
-    icp_mutex.lock();
+    // the coarse levels
+    for (const RegistrationLevel &level : registration_pyramid)
+    {
+        // the downsampled clouds and their features
+        PointCloudHSV::ConstPtr coarse_source, coarse_target;
+        CloudFeatures::ConstPtr coarse_source_features, coarse_target_features;
 
-    // get the point cloud vector size
-    const unsigned upper_limit = point_cloud_lidar_messages->size() - 1;
+        // the target features only when the full resolution target has them
+        // the pcl gicp keeps the precomputed trees flag, so the levels must be consistent
+        GetCoarseCloud(source, source_cloud, level.leaf, true, coarse_source, coarse_source_features);
+        GetCoarseCloud(target, target_cloud, level.leaf, nullptr != target_features, coarse_target, coarse_target_features);
 
-    // verify the start index
-    if (upper_limit > icp_start_index)
+        // the coarse clouds can be too small
+        if (nullptr == coarse_source_features || nullptr == coarse_target || (nullptr != target_features && nullptr == coarse_target_features))
+        {
+            continue;
+        }
+
+        // the voxels should be larger than the points spacing
+        vgicp.SetResolution(std::max(vgicp_resolution, 2.0 * level.leaf));
+
+        // a failed level keeps the previous guess
+        if (AlignLevel(gicp, vgicp, level.distance, level.iterations, coarse_source, coarse_source_features, coarse_target, coarse_target_features, current_guess, transformation, fitness))
+        {
+            current_guess = transformation;
+        }
+    }
+
+    // restore the full resolution voxels
+    vgicp.SetResolution(vgicp_resolution);
+
+    // the full resolution level
+    return AlignLevel(gicp, vgicp, cf, REGISTRATION_MAX_ITERATIONS, source_cloud, source_features, target_cloud, target_features, current_guess, transformation, fitness);
+}
+
+
+// get a downsampled cloud and its features, from the cache when the cloud belongs to a lidar message
+void GrabData::GetCoarseCloud(
+        StampedLidarPtr lidar,
+        PointCloudHSV::ConstPtr cloud,
+        double leaf,
+        bool with_features,
+        PointCloudHSV::ConstPtr &coarse,
+        CloudFeatures::ConstPtr &coarse_features)
+{
+    // the voxel grid filter
+    CloudCache::CloudLoader downsampler([cloud, leaf](PointCloudHSV &filtered)
     {
-        // set the first index
-        first_index = icp_start_index;
+        VoxelGridFilter grid_filtering;
+        grid_filtering.setLeafSize(leaf, leaf, leaf);
+        grid_filtering.setInputCloud(cloud);
+        grid_filtering.filter(filtered);
 
-        // get the end index
-        icp_end_index = icp_start_index + icp_thread_block_size;
+        return true;
+    });
 
-        // verify the end index
-        if (upper_limit < icp_end_index)
+    if (nullptr != lidar)
+    {
+        // the popular clouds are registered many times, so the levels are built once while the cloud is cached
+        if (!cloud_cache.GetLevel(lidar->CloudStore(), lidar->cloud_slot, cloud, leaf, downsampler, coarse, coarse_features))
         {
-            // set the new end index
-            icp_end_index = upper_limit;
+            coarse = nullptr;
+            coarse_features = nullptr;
         }
+    }
+    else
+    {
+        // the local map changes after each registration
+        PointCloudHSV::Ptr filtered(new PointCloudHSV());
 
-        // set the end index
-        last_index = icp_end_index;
+        downsampler(*filtered);
+        filtered->is_dense = false;
 
-        // set the start index to the next thread
-        icp_start_index = icp_end_index;
+        coarse = filtered;
+        coarse_features = with_features ? CloudFeatures::Build(filtered) : CloudFeatures::ConstPtr();
+    }
 
-        // set the status flag
-        status = true;
+    if (!with_features)
+    {
+        coarse_features = nullptr;
     }
+}
 
-    // unlock the mutex
-    icp_mutex.unlock();
 
-    return status;
+// get the lidar cloud from the cache
+PointCloudHSV::ConstPtr GrabData::GetCachedCloud(StampedLidarPtr lidar)
+{
+    return cloud_cache.Get(lidar->CloudStore(), lidar->cloud_slot, [lidar](PointCloudHSV &cloud) { return lidar->LoadCloud(cloud); });
+}
+
+
+// get the registration features of a cached cloud
+CloudFeatures::ConstPtr GrabData::GetCachedFeatures(StampedLidarPtr lidar, PointCloudHSV::ConstPtr cloud)
+{
+    return cloud_cache.GetFeatures(lidar->CloudStore(), lidar->cloud_slot, cloud);
+}
+
+
+// get the next lidar block
+bool GrabData::GetNextLidarBlock(unsigned worker, unsigned &first_index, unsigned &last_index)
+{
+    // the worker own blocks first, then the stolen ones
+    BlockScheduler::Block block;
+
+    if (lidar_scheduler.Next(worker, block))
+    {
+        first_index = block.first;
+        last_index = block.last;
+
+        return true;
+    }
+
+    return false;
+}
+
+
+// the next lidar keyframe
+unsigned GrabData::GetNextKeyframe(const StampedLidarPtrVector &lidar_messages, unsigned current_index, unsigned last_index)
+{
+    // direct access
+    StampedLidarPtr current = lidar_messages[current_index];
+
+    // the stationary segments are limited by the maximum step
+    const unsigned upper_limit = std::min(last_index, current_index + std::max(1u, lidar_keyframe_max_step));
+
+    for (unsigned i = current_index + 1; i <= upper_limit; ++i)
+    {
+        // the odometry displacement
+        g2o::SE2 motion(current->est.inverse() * lidar_messages[i]->est);
+
+        // enough displacement or yaw change
+        if (lidar_keyframe_distance <= motion.translation().norm() || lidar_keyframe_yaw <= std::fabs(motion.rotation().angle()))
+        {
+            return i;
+        }
+
+        // the previous scan was the last one with enough overlap
+        if (lidar_keyframe_min_overlap > current->EstimateOverlap(*lidar_messages[i], motion))
+        {
+            return std::max(current_index + 1, i - 1);
+        }
+    }
+
+    // the block end is always registered
+    return upper_limit;
+}
+
+
+// split the lidar messages in blocks with similar registration costs
+void GrabData::BuildLidarBlocks(const StampedLidarPtrVector &lidar_messages, std::vector<BlockScheduler::Block> &blocks)
+{
+    blocks.clear();
+
+    // get the point cloud vector size
+    const unsigned upper_limit = lidar_messages.size() - 1;
+
+    // the current block
+    unsigned first_index = 0;
+    double distance = 0.0;
+
+    for (unsigned i = 1; i <= upper_limit; ++i)
+    {
+        // the traveled distance, the stationary segments are cheap since the step is larger
+        distance += (lidar_messages[i]->est.translation() - lidar_messages[i - 1]->est.translation()).norm();
+
+        // the message count still limits the block size
+        if (upper_limit == i || icp_thread_block_size <= i - first_index || (0.0 < icp_thread_block_distance && icp_thread_block_distance <= distance))
+        {
+            // the last index is shared with the next block
+            blocks.push_back({ first_index, i });
+
+            first_index = i;
+            distance = 0.0;
+        }
+    }
 }
 
 
@@ -835,7 +966,7 @@ bool GrabData::GetNextICPIterators(StampedLidarPtrVector::iterator &begin, Stamp
 
 
 // the main icp measurement method, multithreaded version
-void GrabData::BuildLidarMeasuresMT()
+void GrabData::BuildLidarMeasuresMT(unsigned worker)
 {
     // this thread iterators
     StampedLidarPtrVector::iterator begin = point_cloud_lidar_messages->begin();
@@ -847,13 +978,16 @@ void GrabData::BuildLidarMeasuresMT()
     // set the default gicp configuration
     gicp.setEuclideanFitnessEpsilon(1e-06);
     gicp.setTransformationEpsilon(1e-06);
-    gicp.setMaximumIterations(2000);
+    gicp.setMaximumIterations(REGISTRATION_MAX_ITERATIONS);
 
-    // the voxel grid filtering
-    VoxelGridFilter grid_filtering;
+    // the voxelized gicp, used instead of the pcl gicp when it's enabled
+    VoxelizedGICP vgicp;
+    vgicp.SetResolution(vgicp_resolution);
+    vgicp.SetThreads(vgicp_threads);
+    vgicp.SetMaxIterations(REGISTRATION_MAX_ITERATIONS);
 
-    // set the voxel value
-    grid_filtering.setLeafSize(StampedLidar::vg_leaf, StampedLidar::vg_leaf, StampedLidar::vg_leaf);
+    // the accumulated local map, with the same leaf size of the cached clouds
+    LocalVoxelMap local_map(StampedLidar::vg_leaf, local_map_radius);
 
     // the local grid map
     // LocalGridMap3D<float> lgm(4.0, 40.0, 30.0f, 5.0f);
@@ -862,10 +996,14 @@ void GrabData::BuildLidarMeasuresMT()
     float lfd = lidar_odometry_min_distance;
 
     // the base path
-    std::string path("/dados/tmp/lgm/");
+    std::string path(ScratchStorage::Path("lgm/"));
 
     bool is_sick = (point_cloud_lidar_messages == &sick_messages);
 
+    // the velodyne sequential edges can be registered in x, y and yaw only
+    vgicp.SetPlanar(!is_sick && use_planar_velodyne_odometry);
+    vgicp.SetGroundLeveling(use_ground_leveling);
+
     if (is_sick)
     {
         // set the sick base path
@@ -896,39 +1034,39 @@ void GrabData::BuildLidarMeasuresMT()
     unsigned percent = unsigned(0.01 * float(point_cloud_lidar_messages->size()));
 
     // get the the range iterators
-    while (GetNextLidarBlock(current_index, last_index))
+    while (GetNextLidarBlock(worker, current_index, last_index))
     {
-        // save the first index to mutex usage
-       unsigned first_index = current_index;
-
         // get the current message pointer
         StampedLidarPtr current = *(begin + current_index);
 
-        // the current cloud
-        pcl::PointCloud<pcl::PointXYZHSV>::Ptr current_cloud(new pcl::PointCloud<pcl::PointXYZHSV>());
+        // the current cloud from the cache
+        PointCloudHSV::ConstPtr cached_cloud(GetCachedCloud(current));
 
-        // try to open the current cloud
-        if (-1 == pcl::io::loadPCDFile(current->path, *current_cloud))
+        if (nullptr == cached_cloud)
         {
             throw std::runtime_error("Could not open the source cloud");
         }
 
+        // the local map accumulates the next clouds in the frame of the first one
+        local_map.Reset(*cached_cloud);
+
         // the main iterator
         while (current_index < last_index)
         {
             // compute the desired StampedMessagePtr
-            unsigned next_index = current_index + unsigned(std::max(1.0, std::min(10.0, lfd / std::fabs(current->speed))));
+            unsigned next_index = 0.0 < lidar_keyframe_distance ?
+                GetNextKeyframe(*point_cloud_lidar_messages, current_index, last_index) :
+                current_index + unsigned(std::max(1.0, std::min(10.0, lfd / std::fabs(current->speed))));
 
             if (next_index <= last_index)
             {
                 // get the next
                 StampedLidarPtr next = *(begin + next_index);
 
-                // the next cloud
-                pcl::PointCloud<pcl::PointXYZHSV>::Ptr next_cloud(new pcl::PointCloud<pcl::PointXYZHSV>());
+                // the next cloud, shared with the other workers
+                PointCloudHSV::ConstPtr next_cloud(GetCachedCloud(next));
 
-                // try to open the next cloud
-               if (-1 == pcl::io::loadPCDFile(next->path, *next_cloud))
+                if (nullptr == next_cloud)
                 {
                     throw std::runtime_error("Could not open the target cloud");
                 }
@@ -936,31 +1074,29 @@ void GrabData::BuildLidarMeasuresMT()
                 // get the factor
                 double cf = double(int(current->speed * (next->timestamp - current->timestamp) * 100.0)) * 0.02;
 
+                // the odometry guess
+                g2o::SE2 odom(current->est.inverse() * next->est);
+
+                // the registration status
+                bool registered = false;
+
                 double dt = next->timestamp - current->timestamp;
                 if (dt > 0 && dt < 600)
                 {
-                    // the odometry guess
-                    g2o::SE2 odom(current->est.inverse() * next->est);
-
                     if (0.0 != cf)
                     {
-                        if (BuildLidarOdometryMeasure(gicp, grid_filtering, cf, odom, current_cloud, next_cloud, current->seq_measurement))
+                        if (BuildLidarOdometryMeasure(gicp, vgicp, cf, odom, local_map, next, next_cloud, GetCachedFeatures(next, next_cloud), current->seq_measurement))
                         {
                             // set the base id
                             current->seq_id = next->id;
 
+                            // the next scan was inserted
+                            registered = true;
+
                             if (save_accumulated_point_clouds)
                             {
-                                if (first_index == current_index || last_index == current_index)
-                                {
-                                    first_last_mutex.lock();
-                                    StampedLidar::SavePointCloud(path, current_index, *current_cloud);
-                                    first_last_mutex.unlock();
-                                }
-                                else
-                                {
-                                    StampedLidar::SavePointCloud(path, current_index, *current_cloud);
-                                }
+                                // the writer thread saves the accumulated cloud in the next scan frame
+                                cloud_writer.Push(path, current_index, *local_map.Cloud(), local_map.Pose().inverse());
                             }
                         }
                         else
@@ -972,6 +1108,12 @@ void GrabData::BuildLidarMeasuresMT()
                     }
                 }
 
+                if (!registered)
+                {
+                    // follow the odometry, so the next guess starts from the next scan
+                    local_map.SetPose(local_map.Pose() * BuildEigenMatrixFromSE2(odom));
+                }
+
                 // update the current pointer
                 current = next;
 
@@ -1000,19 +1142,28 @@ void GrabData::BuildLidarOdometryMeasuresWithThreads(StampedLidarPtrVector &lida
         // set the point cloud lidar_messages to be used inside the lidar
         point_cloud_lidar_messages = &lidar_messages;
 
-        // reset the index
-        icp_start_index = 0;
+        // the blocks, in contiguous runs for each thread
+        std::vector<BlockScheduler::Block> blocks;
+        BuildLidarBlocks(lidar_messages, blocks);
+
+        lidar_scheduler.Reset(blocks, icp_threads_pool_size);
 
         // the thread pool
         std::vector<std::thread> pool(0);
 
+        // the accumulated clouds are saved by a dedicated thread
+        if (save_accumulated_point_clouds)
+        {
+            cloud_writer.Start(cloud_writer_queue_size, cloud_writer_compressed, cloud_writer_drop_when_full);
+        }
+
         // status report
-        std::cout << "Start building the Lidar measurements of " << lidar_messages.size() << " point clouds\n";
+        std::cout << "Start building the Lidar measurements of " << lidar_messages.size() << " point clouds in " << blocks.size() << " blocks\n";
 
         // create the threads using the defined pool size
         for (unsigned i = 0; i < icp_threads_pool_size; ++i)
         {
-            pool.push_back(std::thread(&GrabData::BuildLidarMeasuresMT, this));
+            pool.push_back(std::thread(&GrabData::BuildLidarMeasuresMT, this, i));
         }
 
         // wait all threads
@@ -1023,6 +1174,17 @@ void GrabData::BuildLidarOdometryMeasuresWithThreads(StampedLidarPtrVector &lida
 
         std::cout << "\nLidar odometry errors: " << icp_errors << std::endl;
 
+        // wait the remaining accumulated clouds
+        if (save_accumulated_point_clouds)
+        {
+            unsigned dropped = cloud_writer.Finish();
+
+            if (0 < dropped)
+            {
+                std::cout << "Dropped accumulated clouds: " << dropped << std::endl;
+            }
+        }
+
         // status reporting
         std::cout << "Lidar measurements done!" << std::endl;
     }
@@ -1059,23 +1221,23 @@ void GrabData::BuildLidarOdometryGPSEstimates()
 {
     if (2 < messages.size())
     {
-        StampedMessagePtrVector::iterator first(messages.begin());
-        StampedMessagePtrVector::iterator end(messages.end());
-        StampedMessagePtrVector::iterator it(first);
+        // the columns
+        const std::vector<StampedMessageType> &types(message_store.types);
+        const std::vector<double> &timestamps(message_store.timestamps);
+        const std::vector<unsigned> &payload(message_store.payload);
 
-        while (end != it)
-        {
-            // direct access
-            StampedMessagePtr current = *it;
-            StampedLidarPtr lidar = dynamic_cast<StampedLidarPtr>(current);
+        const unsigned size = message_store.Size();
 
-            if (nullptr != lidar)
+        for (unsigned i = 0; i < size; ++i)
+        {
+            if (StampedVelodyneMessage == types[i])
             {
-                lidar->gps_sync_estimate = GetGPSMeasure(first, it, end, current->timestamp);
+                velodyne_messages[payload[i]]->gps_sync_estimate = GetGPSMeasure(timestamps[i]);
+            }
+            else if (StampedSICKMessage == types[i])
+            {
+                sick_messages[payload[i]]->gps_sync_estimate = GetGPSMeasure(timestamps[i]);
             }
-
-            // go to the next message
-            ++it;
         }
     }
 }
@@ -1203,45 +1365,77 @@ void GrabData::BuildLidarLoopClosureMeasures(StampedLidarPtrVector &lidar_messag
         // report
         std::cout << "Start building the loop closure measurements from " << lidar_messages.size() << " messages\n";
 
-        // the pcl point cloud ICP solver
-        GeneralizedICP gicp;
+        unsigned lmsize = lidar_messages.size();
 
-        // set the default gicp configuration
-        gicp.setEuclideanFitnessEpsilon(1e-06);
-        gicp.setTransformationEpsilon(1e-06);
-        gicp.setMaximumIterations(2000);
+        // the descriptors allow a wider search, the gps estimate can be poor
+        bool use_descriptors = 0 < loop_descriptor_top_k;
 
-        // iterators
-        StampedLidarPtrVector::iterator end(lidar_messages.end());
-        StampedLidarPtrVector::iterator it(lidar_messages.begin());
+        // the search radius
+        double radius = use_descriptors ? std::max(loop_descriptor_search_distance, loop_required_distance) : loop_required_distance;
 
-        unsigned lmsize = lidar_messages.size();
-        unsigned counter = 0;
-        // unsigned percent = lmsize / 100;
+        // the spatial index over the gps synchronized positions
+        SpatialGrid grid(radius);
 
-        while (end != it)
+        for (unsigned i = 0; i < lmsize; ++i)
         {
-            counter += 1;
+            const Eigen::Vector2d &position(lidar_messages[i]->gps_sync_estimate.translation());
+
+            grid.Insert(position[0], position[1], i);
+        }
+
+        // the candidates inside the loop radius
+        std::vector<unsigned> neighbors;
+
+        // the neighbors ranked by the ring key distance
+        std::vector<std::pair<float, unsigned>> ranked;
+
+        // the best descriptor matches of the current message
+        std::vector<std::pair<float, LidarLoopCandidate>> matches;
+
+        // the selected pairs, registered later by the worker threads
+        std::vector<LidarLoopCandidate> candidates;
 
-            std::cout << counter << " of " << lmsize << std::endl;
-            //if (0 == percent % counter) { std::cout << "-"; }
+        // the traveled distance and the traveled distance at the last registration
+        double odometer = 0.0, last_registration = 0.0;
 
+        // is the vehicle revisiting a known place?
+        bool revisiting = false;
+
+        // how many registrations were skipped by the spacing
+        unsigned skipped = 0;
+
+        for (unsigned i = 0; i < lmsize; ++i)
+        {
             // get the current lidar message pointer
-            StampedLidarPtr current = *it;
+            StampedLidarPtr current = lidar_messages[i];
 
-            // the loop iterator
-            StampedLidarPtrVector::iterator loop(end);
+            // update the traveled distance
+            if (0 < i)
+            {
+                odometer += (current->gps_sync_estimate.translation() - lidar_messages[i - 1]->gps_sync_estimate.translation()).norm();
+            }
+
+            // the loop index
+            unsigned loop = lmsize;
 
             // the mininum distance found
             double min_dist = dmax;
 
-            // the next message
-            StampedLidarPtrVector::iterator next(it + 1);
+            // the close positions, only the later messages are valid
+            grid.Query(grid.X(i), grid.Y(i), radius, neighbors);
+
+            ranked.clear();
+            matches.clear();
 
-            while (end != next)
+            for (unsigned next : neighbors)
             {
+                if (i >= next)
+                {
+                    continue;
+                }
+
                 // get the current loop message
-                StampedLidarPtr lidar_loop = *next;
+                StampedLidarPtr lidar_loop = lidar_messages[next];
 
                 // compute the current distance
                 double distance = (current->gps_sync_estimate.translation() - lidar_loop->gps_sync_estimate.translation()).norm();
@@ -1249,52 +1443,218 @@ void GrabData::BuildLidarLoopClosureMeasures(StampedLidarPtrVector &lidar_messag
                 // the time difference
                 double dt = std::fabs(lidar_loop->timestamp - current->timestamp);
 
-                if ((min_dist > distance) && (loop_required_time < dt) && (loop_required_distance > distance))
+                if (loop_required_time >= dt)
+                {
+                    continue;
+                }
+
+                if (use_descriptors)
                 {
+                    // the cheap rotation invariant comparison first
+                    ranked.push_back(std::make_pair(ScanContext::RingKeyDistance(current->descriptor, lidar_loop->descriptor), next));
+                }
+                else if (min_dist > distance || (min_dist == distance && loop > next))
+                {
+                    // the ties go to the earliest message
                     min_dist = distance;
                     loop = next;
                 }
+            }
+
+            if (use_descriptors)
+            {
+                // keep the best ring keys, the ties go to the earliest message
+                std::sort(ranked.begin(), ranked.end());
+
+                if (LOOP_DESCRIPTOR_RING_CANDIDATES < ranked.size())
+                {
+                    ranked.resize(LOOP_DESCRIPTOR_RING_CANDIDATES);
+                }
+
+                for (const std::pair<float, unsigned> &rank : ranked)
+                {
+                    // the loop message
+                    StampedLidarPtr lidar_loop = lidar_messages[rank.second];
+
+                    // the full comparison, it also estimates the yaw between the scans
+                    double yaw = 0.0;
+                    float score = ScanContext::Distance(current->descriptor, lidar_loop->descriptor, yaw);
+
+                    if (loop_descriptor_max_distance > score)
+                    {
+                        double distance = (current->gps_sync_estimate.translation() - lidar_loop->gps_sync_estimate.translation()).norm();
+
+                        matches.push_back(std::make_pair(score, LidarLoopCandidate { i, rank.second, distance, yaw, g2o::SE2(0.0, 0.0, 0.0), false, dmax }));
+                    }
+                }
+
+                // the top k matches go to the registration
+                std::stable_sort(matches.begin(), matches.end(),
+                    [](const std::pair<float, LidarLoopCandidate> &a, const std::pair<float, LidarLoopCandidate> &b) { return a.first < b.first; });
+
+                if (loop_descriptor_top_k < matches.size())
+                {
+                    matches.resize(loop_descriptor_top_k);
+                }
+            }
+            else if (lmsize != loop)
+            {
+                matches.push_back(std::make_pair(0.0f, LidarLoopCandidate { i, loop, min_dist, 0.0, g2o::SE2(0.0, 0.0, 0.0), false, dmax }));
+            }
+
+            if (!matches.empty())
+            {
+                // the first query of each revisit is always registered, the next ones after the spacing
+                if (revisiting && loop_closure_spacing > odometer - last_registration)
+                {
+                    ++skipped;
+
+                    continue;
+                }
+
+                revisiting = true;
+                last_registration = odometer;
+
+                // save the pairs
+                for (const std::pair<float, LidarLoopCandidate> &match : matches)
+                {
+                    candidates.push_back(match.second);
+                }
+            }
+            else
+            {
+                // the revisit is over
+                revisiting = false;
+            }
+        }
+
+        std::cout << "Registering " << candidates.size() << " loop closure candidates, skipped by the spacing: " << skipped << std::endl;
+
+        // reset the index
+        loop_candidate_index = 0;
+
+        // the thread pool
+        std::vector<std::thread> pool(0);
+
+        // each thread has its own gicp
+        for (unsigned i = 0; i < icp_threads_pool_size; ++i)
+        {
+            pool.push_back(std::thread(&GrabData::BuildLidarLoopMeasuresMT, this, &lidar_messages, &candidates));
+        }
+
+        // wait all threads
+        for (unsigned i = 0; i < icp_threads_pool_size; ++i)
+        {
+            pool[i].join();
+        }
+
+        // write the results in the candidates order, it doesn't depend on the threads scheduling
+        // each message keeps the converged pair with the best fitness
+        double best_fitness = dmax;
+        unsigned best_query = lmsize;
+
+        for (const LidarLoopCandidate &candidate : candidates)
+        {
+            if (best_query != candidate.query)
+            {
+                best_query = candidate.query;
+                best_fitness = dmax;
+            }
+
+            if (candidate.converged && best_fitness > candidate.fitness)
+            {
+                StampedLidarPtr current = lidar_messages[candidate.query];
+
+                current->loop_measurement = candidate.measurement;
+                current->loop_closure_id = lidar_messages[candidate.loop]->id;
+
+                best_fitness = candidate.fitness;
+            }
+        }
+
+        // the cache statistics
+        std::size_t hits = 0, misses = 0;
+        cloud_cache.Statistics(hits, misses);
+
+        // report
+        std::cout << "Lidar loop closure measurements done! Cloud cache hits: " << hits << ", misses: " << misses << "\n";
+    }
+}
+
+
+// get the next loop closure candidate
+bool GrabData::GetNextLoopCandidate(unsigned size, unsigned &index)
+{
+    // lock the mutex
+    std::unique_lock<std::mutex> lock(icp_mutex);
+
+    if (size > loop_candidate_index)
+    {
+        index = loop_candidate_index++;
+
+        // status report
+        if (0 == index % 100)
+        {
+            std::cout << index << " of " << size << std::endl;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+// register the loop closure candidates, multithreading version
+void GrabData::BuildLidarLoopMeasuresMT(const StampedLidarPtrVector *lidar_messages, std::vector<LidarLoopCandidate> *candidates)
+{
+    // the pcl point cloud ICP solver
+    GeneralizedICP gicp;
 
-                // go the next loop
-                ++next;
-            }
+    // set the default gicp configuration
+    gicp.setEuclideanFitnessEpsilon(1e-06);
+    gicp.setTransformationEpsilon(1e-06);
+    gicp.setMaximumIterations(REGISTRATION_MAX_ITERATIONS);
 
-            if (end != loop)
-            {
-                // the current cloud
-                pcl::PointCloud<pcl::PointXYZHSV>::Ptr current_cloud(new pcl::PointCloud<pcl::PointXYZHSV>());
+    // the voxelized gicp, used instead of the pcl gicp when it's enabled
+    VoxelizedGICP vgicp;
+    vgicp.SetResolution(vgicp_resolution);
+    vgicp.SetThreads(vgicp_threads);
+    vgicp.SetMaxIterations(REGISTRATION_MAX_ITERATIONS);
 
-                // try to open the current cloud
-                if (-1 == pcl::io::loadPCDFile(current->path, *current_cloud))
-                {
-                    throw std::runtime_error("Could not open the source cloud");
-                }
+    // the velodyne loop edges can be registered in x, y and yaw only
+    vgicp.SetPlanar(lidar_messages == &velodyne_messages && use_planar_velodyne_loop);
+    vgicp.SetGroundLeveling(use_ground_leveling);
 
-                // found it
-                StampedLidarPtr lidar_loop = *loop;
+    // the current candidate
+    unsigned index;
 
-                // load the loop cloud
-                pcl::PointCloud<pcl::PointXYZHSV>::Ptr loop_cloud(new pcl::PointCloud<pcl::PointXYZHSV>());
+    while (GetNextLoopCandidate(candidates->size(), index))
+    {
+        LidarLoopCandidate &candidate((*candidates)[index]);
 
-                // try to open the next cloud
-                if (-1 == pcl::io::loadPCDFile(lidar_loop->path, *loop_cloud))
-                {
-                    throw std::runtime_error("Could not open the target cloud");
-                }
+        // the current cloud from the cache
+        PointCloudHSV::ConstPtr current_cloud(GetCachedCloud((*lidar_messages)[candidate.query]));
 
-                // try the icp method
-                if (BuildLidarLoopMeasure(gicp, min_dist * 2.0, current_cloud, loop_cloud, current->loop_measurement))
-                {
-                    current->loop_closure_id = lidar_loop->id;
-                }
-            }
+        if (nullptr == current_cloud)
+        {
+            throw std::runtime_error("Could not open the source cloud");
+        }
 
-            // go to the next message
-            ++it;
+        // the loop cloud from the cache
+        PointCloudHSV::ConstPtr loop_cloud(GetCachedCloud((*lidar_messages)[candidate.loop]));
+
+        if (nullptr == loop_cloud)
+        {
+            throw std::runtime_error("Could not open the target cloud");
         }
 
-        // report
-        std::cout << "Lidar loop closure measurements done!\n";
+        // try the icp method, each candidate has its own result slot
+        // the cached trees and covariances
+        CloudFeatures::ConstPtr current_features(GetCachedFeatures((*lidar_messages)[candidate.query], current_cloud));
+        CloudFeatures::ConstPtr loop_features(GetCachedFeatures((*lidar_messages)[candidate.loop], loop_cloud));
+
+        candidate.converged = BuildLidarLoopMeasure(gicp, vgicp, candidate.distance * 2.0, (*lidar_messages)[candidate.query], (*lidar_messages)[candidate.loop], current_cloud, loop_cloud, current_features, loop_features, g2o::SE2(0.0, 0.0, candidate.yaw), candidate.measurement, candidate.fitness);
     }
 }
 
@@ -1434,6 +1794,10 @@ void GrabData::SaveOdometryEdges(std::ofstream &os)
 
         std::string _s(" ");
 
+        // the type tags, the same order of the messages list
+        const std::vector<StampedMessageType> &types(message_store.types);
+        unsigned index = 0;
+
         while (end != next)
         {
             // direct acccess
@@ -1454,19 +1818,20 @@ void GrabData::SaveOdometryEdges(std::ofstream &os)
             // write the odometry measurements
             os << "ODOM_EDGE " << a->id << _s << b->id << _s << std::fixed << dx << _s << dy << _s << yaw << _s << rv << _s << rphi << _s << dt << "\n";
 
-            // try to downcast to odometyr msg
-            odom = dynamic_cast<StampedOdometryPtr>(a);
-
-            if (nullptr != odom)
+            // check the type tag
+            if (StampedOdometryMessage == types[index])
             {
                 // update the speed and steering angle
-                rv = odom->raw_v;
-                rphi = odom->raw_phi;
+                const OdometryCommand &command(message_store.odometry[message_store.payload[index]]);
+
+                rv = command.raw_v;
+                rphi = command.raw_phi;
             }
 
             // go to the next messages
            current = next;
             ++next;
+            ++index;
         }
     }
 }
@@ -1852,6 +2217,22 @@ void GrabData::Configure(std::string config_filename, std::string carmen_ini)
             {
                 ss >> loop_required_distance;
             }
+            else  if ("LOOP_CLOSURE_SPACING" == str)
+            {
+                ss >> loop_closure_spacing;
+            }
+            else  if ("LOOP_DESCRIPTOR_TOP_K" == str)
+            {
+                ss >> loop_descriptor_top_k;
+            }
+            else  if ("LOOP_DESCRIPTOR_SEARCH_DISTANCE" == str)
+            {
+                ss >> loop_descriptor_search_distance;
+            }
+            else  if ("LOOP_DESCRIPTOR_MAX_DISTANCE" == str)
+            {
+                ss >> loop_descriptor_max_distance;
+            }
             else  if ("ICP_THREADS_POOL_SIZE" == str)
             {
                 ss >> icp_threads_pool_size;
@@ -1860,6 +2241,10 @@ void GrabData::Configure(std::string config_filename, std::string carmen_ini)
             {
                 ss >> icp_thread_block_size;
             }
+            else if ("ICP_THREAD_BLOCK_DISTANCE" == str)
+            {
+                ss >> icp_thread_block_distance;
+            }
             else  if ("LIDAR_ODOMETRY_MIN_DISTANCE" == str)
             {
                 ss >> lidar_odometry_min_distance;
@@ -1934,6 +2319,106 @@ void GrabData::Configure(std::string config_filename, std::string carmen_ini)
                 std::cout << "Disabling visual loop closures" << std::endl;
                 use_bumblebee_loop = false;
             }
+            else if ("LOG_PARSER_THREADS" == str)
+            {
+                ss >> log_parser_threads;
+            }
+            else if ("VELODYNE_DECODER_THREADS" == str)
+            {
+                ss >> velodyne_decoder_threads;
+            }
+            else if ("VELODYNE_DECODER_QUEUE_SIZE" == str)
+            {
+                ss >> velodyne_decoder_queue_size;
+            }
+            else if ("CLOUD_WRITER_QUEUE_SIZE" == str)
+            {
+                ss >> cloud_writer_queue_size;
+            }
+            else if ("CLOUD_WRITER_COMPRESSED" == str)
+            {
+                cloud_writer_compressed = true;
+            }
+            else if ("CLOUD_WRITER_DROP_WHEN_FULL" == str)
+            {
+                std::cout << "The accumulated clouds are dropped when the writer queue is full" << std::endl;
+                cloud_writer_drop_when_full = true;
+            }
+            else if ("SCRATCH_ROOT" == str)
+            {
+                ss >> scratch_root;
+            }
+            else if ("USE_IN_MEMORY_SCRATCH" == str)
+            {
+                std::cout << "Keeping the intermediate clouds and images in memory" << std::endl;
+                use_in_memory_scratch = true;
+            }
+            else if ("LIDAR_KEYFRAME_DISTANCE" == str)
+            {
+                ss >> lidar_keyframe_distance;
+            }
+            else if ("LIDAR_KEYFRAME_YAW" == str)
+            {
+                ss >> lidar_keyframe_yaw;
+            }
+            else if ("LIDAR_KEYFRAME_MIN_OVERLAP" == str)
+            {
+                ss >> lidar_keyframe_min_overlap;
+            }
+            else if ("LIDAR_KEYFRAME_MAX_STEP" == str)
+            {
+                ss >> lidar_keyframe_max_step;
+            }
+            else if ("LOCAL_MAP_RADIUS" == str)
+            {
+                ss >> local_map_radius;
+            }
+            else if ("CLOUD_CACHE_MB" == str)
+            {
+                ss >> cloud_cache_mb;
+            }
+            else if ("DISABLE_MMAP_LOG_READER" == str)
+            {
+                std::cout << "Disabling the memory mapped log reader" << std::endl;
+                use_mmap_log_reader = false;
+            }
+            else if ("USE_VGICP" == str)
+            {
+                std::cout << "Using the voxelized gicp registration" << std::endl;
+                use_vgicp = true;
+            }
+            else if ("VGICP_RESOLUTION" == str)
+            {
+                ss >> vgicp_resolution;
+            }
+            else if ("REGISTRATION_LEVEL" == str)
+            {
+                RegistrationLevel level { 0.0, 0, 0.0 };
+                ss >> level.leaf >> level.iterations >> level.distance;
+                if (0.0 < level.leaf && 0 < level.iterations && 0.0 < level.distance)
+                {
+                    registration_pyramid.push_back(level);
+                }
+            }
+            else if ("VGICP_THREADS" == str)
+            {
+                ss >> vgicp_threads;
+            }
+            else if ("PLANAR_VELODYNE_ODOMETRY" == str)
+            {
+                std::cout << "Using the planar registration in the velodyne odometry" << std::endl;
+                use_planar_velodyne_odometry = true;
+            }
+            else if ("PLANAR_VELODYNE_LOOP" == str)
+            {
+                std::cout << "Using the planar registration in the velodyne loop closures" << std::endl;
+                use_planar_velodyne_loop = true;
+            }
+            else if ("PLANAR_GROUND_LEVELING" == str)
+            {
+                std::cout << "Using the ground planes roll and pitch in the planar registration" << std::endl;
+                use_ground_leveling = true;
+            }
             else if ("USE_FAKE_GPS" == str)
             {
                 use_fake_gps = true;
@@ -1958,6 +2443,18 @@ void GrabData::Configure(std::string config_filename, std::string carmen_ini)
 
     is.close();
 
+    // the cloud cache memory budget
+    cloud_cache.SetBudget(cloud_cache_mb);
+
+    // the scratch storage
+    ScratchStorage::Configure(scratch_root, use_in_memory_scratch);
+
+    if (use_in_memory_scratch && save_accumulated_point_clouds)
+    {
+        std::cout << "The in memory scratch storage doesn't save the accumulated point clouds" << std::endl;
+        save_accumulated_point_clouds = false;
+    }
+
     SetGPSPose(carmen_ini);
 }
 
@@ -2031,129 +2528,346 @@ void GrabData::SetGPSPose(std::string carmen_ini)
     is.close();
 }
 
-// the main process
-// it reads the entire log file and builds the hypergraph
-bool GrabData::ParseLogFile(const std::string &input_filename)
+// build a new message based on the log tag
+StampedMessagePtr GrabData::CreateMessageFromTag(const LogLine &tag)
 {
-    // the input file stream
-    std::ifstream logfile(input_filename);
-
-    if (!logfile.is_open())
+    // the tags are compared in place, so the discarded lines are never copied
+    if (tag.Equals("XSENS_QUAT_"))
     {
-        std::cerr << "Unable to open the input file: " << input_filename << "\n";
-        return false;
+        // build a new XSENS orientation message
+        return xsens_pool.Create(0);
+    }
+    else if (tag.Equals("ROBOTVELOCITY_ACK"))
+    {
+        // build a new odometry message
+        return odometry_pool.Create(0);
+    }
+    else if (tag.Equals("NMEAGGA"))
+    {
+        // build a new GPS pose message
+        return gps_pose_pool.Create(0);
+    }
+    else if (!use_fake_gps && tag.Equals("NMEAHDT"))
+    {
+        // build a new GPS orientation message
+        return gps_orientation_pool.Create(0);
+    }
+    else if ((use_sick_odometry or use_sick_loop) and tag.Equals("LASER_LDMRS_NEW"))
+    {
+        // build a new sick message
+        return sick_pool.Create(0);
+    }
+    else if ((use_bumblebee_odometry or use_bumblebee_loop) and tag.Equals("BUMBLEBEE_BASIC_STEREOIMAGE_IN_FILE3____"))   // ZED eh FILE4. Os "_____" sao para nao considerar esta mensagem
+    {
+        // parse the Bumblebee stereo image message
+        return bumblebee_pool.Create(0);
+    }
+    else if ((use_velodyne_odometry or use_velodyne_loop) and (tag.Equals("VELODYNE_PARTIAL_SCAN_IN_FILE") or tag.Equals("VELODYNE_PARTIAL_SCAN")))
+    {
+        // build a new velodyne message
+        return velodyne_pool.Create(0);
     }
 
-    // status report
-    std::cout << "Start reading the input logfile (this may take a while)\n";
+    return nullptr;
+}
 
-    // the input string stream
-    std::stringstream current_line;
 
-    // a general counter
-    unsigned counter = 0;
+// destroy a single message, its memory is released with the pool
+void GrabData::DestroyMessage(StampedMessagePtr msg)
+{
+    // the pools need the derived type
+    switch (msg->GetType())
+    {
+        case StampedXsensMessage:
+            xsens_pool.Destroy(dynamic_cast<StampedXSENSPtr>(msg));
+            break;
 
-    // how many velodyne messages
-    unsigned vldn_msgs = 0;
+        case StampedOdometryMessage:
+            odometry_pool.Destroy(dynamic_cast<StampedOdometryPtr>(msg));
+            break;
 
-    // the msg id
-    // we must start with 6
-    unsigned msg_id = 6;
+        case StampedGPSMessage:
+            gps_pose_pool.Destroy(dynamic_cast<StampedGPSPosePtr>(msg));
+            break;
 
-    // how many messages
-    unsigned vel_scans = 0 == maximum_vel_scans ? std::numeric_limits<unsigned>::max() : maximum_vel_scans;
+        case StampedGPSOrientationMessage:
+            gps_orientation_pool.Destroy(dynamic_cast<StampedGPSOrientationPtr>(msg));
+            break;
 
-    // how many messages
-    unsigned percent = vel_scans * 0.1;
+        case StampedSICKMessage:
+            sick_pool.Destroy(dynamic_cast<StampedSICKPtr>(msg));
+            break;
+
+        case StampedBumblebeeMessage:
+            bumblebee_pool.Destroy(dynamic_cast<StampedBumblebeePtr>(msg));
+            break;
+
+        case StampedVelodyneMessage:
+            velodyne_pool.Destroy(dynamic_cast<StampedVelodynePtr>(msg));
+            break;
+    }
+}
 
-    // parse the carmen log file and extract all the desired infos
-    while(-1 != StringHelper::ReadLine(logfile, current_line) && vel_scans > vldn_msgs)
-    {
-        // the input tag
-        std::string tag;
 
-        // the first word is the message name
-        current_line >> tag;
+// parse a single log line
+StampedMessagePtr GrabData::ParseLogLine(const LogLine &line, unsigned &vldn_msgs)
+{
+    // the tag and the arguments views
+    LogLine tag, args;
+
+    // the first word is the message name
+    line.SplitTag(tag, args);
 
-        // the new message
-        StampedMessagePtr msg = nullptr;
+    // the new message, the id is assigned after the parsing
+    StampedMessagePtr msg = CreateMessageFromTag(tag);
 
-        // take care of each message
-        if ("XSENS_QUAT_" == tag)
+    if (nullptr != msg)
+    {
+        if (StampedVelodyneMessage == msg->GetType())
         {
-            // build a new XSENS orientation message
-            msg = new StampedXSENS(msg_id);
+            // increment the velodyne messages
+            ++vldn_msgs;
         }
-        else if ("ROBOTVELOCITY_ACK" == tag)
+
+        // the arguments tokens, parsed in place
+        LogTokenizer tokens(args);
+
+        // parse the arguments based on the derived class implementation
+        if (!msg->FromCarmenLog(tokens))
         {
-            // build a new odometry message
-            msg = new StampedOdometry(msg_id);
+            DestroyMessage(msg);
+            msg = nullptr;
         }
-        else if ("NMEAGGA" == tag)
+        else if (StampedVelodyneMessage == msg->GetType())
         {
-            // build a new GPS pose message
-            msg = new StampedGPSPose(msg_id);
+            // the scan is decoded by the pipeline threads
+            velodyne_decoder.Push(dynamic_cast<StampedVelodynePtr>(msg));
         }
-        else if (!use_fake_gps && "NMEAHDT" == tag)
+    }
+
+    return msg;
+}
+
+
+// parse a newline aligned byte range of the mapped log file
+void GrabData::ParseLogRange(const MappedLogFile *logfile, std::size_t first, std::size_t last, unsigned vel_scans, StampedMessagePtrVector *output)
+{
+    // the current line view
+    LogLine current_line;
+
+    // how many velodyne messages inside this range
+    unsigned vldn_msgs = 0;
+
+    while (vel_scans > vldn_msgs && logfile->ReadLine(current_line, first, last))
+    {
+        StampedMessagePtr msg = ParseLogLine(current_line, vldn_msgs);
+
+        if (nullptr != msg)
         {
-            // build a new GPS orientation message
-            msg = new StampedGPSOrientation(msg_id);
+            output->push_back(msg);
         }
-        else if ((use_sick_odometry or use_sick_loop) and "LASER_LDMRS_NEW" == tag)
+    }
+}
+
+
+// keep the first vel_scans velodyne messages and assign the sequential message ids
+void GrabData::FinishParsedMessages(unsigned vel_scans)
+{
+    // how many velodyne messages
+    unsigned vldn_msgs = 0;
+
+    // the msg id
+    // we must start with 6
+    unsigned msg_id = 6;
+
+    // the valid messages
+    StampedMessagePtrVector::iterator it(raw_messages.begin());
+    StampedMessagePtrVector::iterator end(raw_messages.end());
+
+    while (end != it && vel_scans > vldn_msgs)
+    {
+        if (StampedVelodyneMessage == (*it)->GetType())
         {
-            // build a new sick message
-            msg = new StampedSICK(msg_id);
+            ++vldn_msgs;
         }
-        else if ((use_bumblebee_odometry or use_bumblebee_loop) and "BUMBLEBEE_BASIC_STEREOIMAGE_IN_FILE3____" == tag)   // ZED eh FILE4. Os "_____" sao para nao considerar esta mensagem
+
+        // the ids follow the log order, so the parallel parser gives the same ids as the sequential one
+        (*it)->id = msg_id++;
+
+        ++it;
+    }
+
+    // the parser threads may read some messages after the last desired velodyne scan
+    for (StampedMessagePtrVector::iterator extra = it; end != extra; ++extra)
+    {
+        DestroyMessage(*extra);
+    }
+
+    raw_messages.erase(it, end);
+}
+
+
+// the main process
+// it reads the entire log file and builds the hypergraph
+bool GrabData::ParseLogFile(const std::string &input_filename)
+{
+    // the memory mapped log file
+    MappedLogFile mapped_logfile;
+
+    // the input file stream, used only when the log can't be mapped
+    std::ifstream logfile;
+
+    // try to map the entire log file
+    bool use_mmap = use_mmap_log_reader && mapped_logfile.Open(input_filename);
+
+    if (!use_mmap)
+    {
+        logfile.open(input_filename);
+
+        if (!logfile.is_open())
         {
-            // parse the Bumblebee stereo image message
-            msg = new StampedBumblebee(msg_id);
+            std::cerr << "Unable to open the input file: " << input_filename << "\n";
+            return false;
         }
-        else if ((use_velodyne_odometry or use_velodyne_loop) and ("VELODYNE_PARTIAL_SCAN_IN_FILE" == tag or "VELODYNE_PARTIAL_SCAN" == tag))
-        {
-            // build a new velodyne message
-            msg = new StampedVelodyne(msg_id);
+    }
 
-            // increment the velodyne messages
-            ++vldn_msgs;
-        }
-        else
+    // status report
+    std::cout << "Start reading the input logfile (this may take a while)\n";
+
+    // how many messages
+    unsigned vel_scans = 0 == maximum_vel_scans ? std::numeric_limits<unsigned>::max() : maximum_vel_scans;
+
+    // the packed cloud stores, a single data file per sensor or the process memory
+    if (ScratchStorage::InMemory())
+    {
+        StampedVelodyne::cloud_store.OpenInMemory();
+        StampedSICK::cloud_store.OpenInMemory();
+    }
+    else if (!StampedVelodyne::cloud_store.Open(ScratchStorage::Path(StampedVelodyne::base_velodyne_path)) ||
+            !StampedSICK::cloud_store.Open(ScratchStorage::Path(StampedSICK::base_sick_path)))
+    {
+        std::cerr << "Unable to create the cloud stores, verify the tmp/velodyne/ and tmp/sick/ directories\n";
+        return false;
+    }
+
+    // start the velodyne decoders
+    velodyne_decoder.Start(velodyne_decoder_threads, velodyne_decoder_queue_size);
+
+    // the parser threads can't tell which velodyne scans come first in the log,
+    // so a limited number of scans is parsed sequentially, otherwise each thread would decode the entire limit
+    if (use_mmap && 1 < log_parser_threads && 0 == maximum_vel_scans)
+    {
+        // split the log in newline aligned byte ranges
+        std::vector<std::size_t> limits(mapped_logfile.SplitLines(log_parser_threads));
+
+        // each thread builds its own message vector
+        std::vector<StampedMessagePtrVector> chunks(limits.size() - 1);
+
+        // the exception thrown by each thread, rethrown after all the joins
+        std::vector<std::exception_ptr> errors(chunks.size(), nullptr);
+
+        // the thread pool
+        std::vector<std::thread> pool(0);
+
+        for (unsigned i = 0; i < chunks.size(); ++i)
         {
-            // go to the next iteration
-            continue;
+            pool.push_back(std::thread([this, &mapped_logfile, &limits, &chunks, &errors, vel_scans, i]()
+            {
+                try
+                {
+                    ParseLogRange(&mapped_logfile, limits[i], limits[i + 1], vel_scans, &chunks[i]);
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            }));
         }
 
-        // parse the stringstream based on the derived class implementation
-        if(msg->FromCarmenLog(current_line))
+        // merge the chunks in the log order
+        for (unsigned i = 0; i < chunks.size(); ++i)
         {
-            // update the msg id
-            ++msg_id;
+            pool[i].join();
 
-            // save it to the msg vector
-            raw_messages.push_back(msg);
+            raw_messages.insert(raw_messages.end(), chunks[i].begin(), chunks[i].end());
 
-            // increment the counter
-            ++counter;
+            // status report
+            std::cout << "#" << std::flush;
+        }
 
-            if (percent < counter)
+        // the first error in the log order
+        for (std::exception_ptr error : errors)
+        {
+            if (nullptr != error)
             {
-            	// reset the counter value
-            	counter = 0;
+                std::rethrow_exception(error);
+            }
+        }
+    }
+    else if (use_mmap)
+    {
+        // the entire log in a single range
+        ParseLogRange(&mapped_logfile, 0, mapped_logfile.Size(), vel_scans, &raw_messages);
+    }
+    else
+    {
+        // the line buffer, used by the stream reader
+        std::string line_buffer;
+
+        // how many velodyne messages
+        unsigned vldn_msgs = 0;
+
+        // parse the carmen log file and extract all the desired infos
+        while (vel_scans > vldn_msgs)
+        {
+            // the stream reader copies the line to the local buffer
+            if (!std::getline(logfile, line_buffer)) { break; }
+
+            StampedMessagePtr msg = ParseLogLine(LogLine(line_buffer.data(), line_buffer.data() + line_buffer.size()), vldn_msgs);
 
-            	// status report
-            	std::cout << "#" << std::flush;
+            if (nullptr != msg)
+            {
+                raw_messages.push_back(msg);
             }
         }
-        else
+    }
+
+    // wait the last velodyne scans
+    std::vector<StampedVelodynePtr> failed(velodyne_decoder.Finish());
+
+    if (!failed.empty())
+    {
+        // remove the scans that could not be decoded
+        std::sort(failed.begin(), failed.end());
+
+        StampedMessagePtrVector::iterator valid = std::remove_if(raw_messages.begin(), raw_messages.end(), [&failed](StampedMessagePtr msg)
+        {
+            return StampedVelodyneMessage == msg->GetType() && std::binary_search(failed.begin(), failed.end(), dynamic_cast<StampedVelodynePtr>(msg));
+        });
+
+        for (StampedVelodynePtr velodyne : failed)
         {
-            delete msg;
+            velodyne_pool.Destroy(velodyne);
         }
+
+        raw_messages.erase(valid, raw_messages.end());
     }
 
-    // close the streams
-    logfile.close();
+    // the clouds are read only from now on
+    if (!StampedVelodyne::cloud_store.Seal() || !StampedSICK::cloud_store.Seal())
+    {
+        std::cerr << "Unable to map the cloud stores\n";
+        return false;
+    }
 
-    std::cout << std::endl;
+    // the ids are assigned after the merge
+    FinishParsedMessages(vel_scans);
+
+    std::cout << "\n" << raw_messages.size() << " messages were parsed" << std::endl;
+
+    // close the log file
+    mapped_logfile.Close();
+    logfile.close();
 
     // success!
     return true;
@@ -2328,17 +3042,26 @@ void GrabData::Clear()
 
     // clear the messages list
     messages.clear();
-
-    // the messages vector needs to be deleted from memmory
-    while (!raw_messages.empty())
-    {
-        // get the last element
-        StampedMessagePtr tmp = raw_messages.back();
-
-        // remove the last element from the vector
-        raw_messages.pop_back();
-
-        // delete the message from memmory
-        delete tmp;
-    }
+    message_store.Clear();
+
+    // the messages live in the pools
+    raw_messages.clear();
+
+    // an exception may have left the pipelines running, the decoders still hold scans from the velodyne pool
+    velodyne_decoder.Stop();
+    cloud_writer.Stop();
+
+    // release all the messages at once, one pool per message type
+    xsens_pool.Release();
+    odometry_pool.Release();
+    gps_pose_pool.Release();
+    gps_orientation_pool.Release();
+    sick_pool.Release();
+    bumblebee_pool.Release();
+    velodyne_pool.Release();
+
+    // release the cached and the packed clouds
+    cloud_cache.Clear();
+    StampedVelodyne::cloud_store.Close();
+    StampedSICK::cloud_store.Close();
 }
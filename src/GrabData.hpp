@@ -19,11 +19,22 @@
 #include <StampedSICK.hpp>
 #include <StampedVelodyne.hpp>
 #include <StampedBumblebee.hpp>
+#include <StampedMessageStore.hpp>
 #include <EdgeGPS.hpp>
 
 #include <VehicleModel.hpp>
+#include <VelodyneDecodePipeline.hpp>
+#include <CloudWriterPipeline.hpp>
 #include <LocalGridMap3D.hpp>
 #include <StringHelper.hpp>
+#include <MappedLogFile.hpp>
+#include <CloudCache.hpp>
+#include <SlabPool.hpp>
+#include <ScratchStorage.hpp>
+#include <SpatialGrid.hpp>
+#include <VoxelizedGICP.hpp>
+#include <LocalVoxelMap.hpp>
+#include <BlockScheduler.hpp>
 #include <Wrap2pi.hpp>
 
 #include <matrix.h>
@@ -35,26 +46,79 @@ namespace hyper {
 #define MAXIMUM_VEL_SCANS 0
 #define LOOP_REQUIRED_TIME 300.0
 #define LOOP_REQUIRED_DISTANCE 5.0
+#define LOOP_CLOSURE_SPACING 0.0
+#define LOOP_DESCRIPTOR_TOP_K 0
+#define LOOP_DESCRIPTOR_SEARCH_DISTANCE 30.0
+#define LOOP_DESCRIPTOR_MAX_DISTANCE 0.4
+#define LOOP_DESCRIPTOR_RING_CANDIDATES 10
 #define ICP_THREADS_POOL_SIZE 12
 #define ICP_THREAD_BLOCK_SIZE 400
+#define ICP_THREAD_BLOCK_DISTANCE 0.0
 #define LIDAR_ODOMETRY_MIN_DISTANCE 0.3
+#define LIDAR_KEYFRAME_DISTANCE 0.0
+#define LIDAR_KEYFRAME_YAW 0.2
+#define LIDAR_KEYFRAME_MIN_OVERLAP 0.7
+#define LIDAR_KEYFRAME_MAX_STEP 10
+#define LOCAL_MAP_RADIUS 0.0
 #define VISUAL_ODOMETRY_MIN_DISTANCE 0.1
 #define ICP_TRANSLATION_CONFIDENCE_FACTOR 1.00
 #define CURVATURE_REQUIRED_TIME 0.0001
+#define LOG_PARSER_THREADS 1
+#define CLOUD_CACHE_MB 1024
+#define REGISTRATION_MAX_ITERATIONS 2000
 
     // define the gicp
     typedef pcl::GeneralizedIterativeClosestPoint<pcl::PointXYZHSV, pcl::PointXYZHSV> GeneralizedICP;
 
+    // a coarse registration level, the clouds are downsampled with the leaf size
+    struct RegistrationLevel
+    {
+        double leaf;
+        unsigned iterations;
+        double distance;
+    };
+
+    // a loop closure candidate pair and its registration result
+    struct LidarLoopCandidate
+    {
+        // the query and loop positions inside the lidar list
+        unsigned query, loop;
+
+        // the distance between them
+        double distance;
+
+        // the initial yaw guess
+        double yaw;
+
+        // the registration result
+        g2o::SE2 measurement;
+        bool converged;
+        double fitness;
+    };
+
     class GrabData
     {
         private:
 
+            // the message pools, one contiguous pool per message type
+            // they are declared before the message lists, so they outlive them
+            SlabPool<StampedXSENS> xsens_pool;
+            SlabPool<StampedOdometry> odometry_pool;
+            SlabPool<StampedGPSPose> gps_pose_pool;
+            SlabPool<StampedGPSOrientation> gps_orientation_pool;
+            SlabPool<StampedSICK> sick_pool;
+            SlabPool<StampedBumblebee> bumblebee_pool;
+            SlabPool<StampedVelodyne> velodyne_pool;
+
             // the raw input message list
             StampedMessagePtrVector raw_messages;
 
             // the main and general message queue
             StampedMessagePtrVector messages;
 
+            // the same messages as type tagged columns, used by the sequential passes
+            StampedMessageStore message_store;
+
             // a gps list to help the filtering process
             StampedGPSPosePtrVector gps_messages;
 
@@ -91,12 +155,27 @@ namespace hyper {
             // the current lidar message iterator index to be used in the ICP measure methods
             unsigned icp_start_index, icp_end_index;
 
+            // the lidar blocks of each icp thread, the idle threads steal from the busy ones
+            BlockScheduler lidar_scheduler;
+
+            // the next loop closure candidate to be registered
+            unsigned loop_candidate_index;
+
             // mutex to avoid racing conditions
-            std::mutex icp_mutex, first_last_mutex, error_increment_mutex;
+            std::mutex icp_mutex, error_increment_mutex;
 
             // the icp error counter
             unsigned icp_errors;
 
+            // decodes the velodyne scans while the log is parsed
+            VelodyneDecodePipeline velodyne_decoder;
+
+            // saves the accumulated clouds while the icp threads run
+            CloudWriterPipeline cloud_writer;
+
+            // the filtered clouds shared by the icp and loop closure workers
+            CloudCache cloud_cache;
+
             // helper
             double dmax;
 
@@ -104,9 +183,30 @@ namespace hyper {
             unsigned maximum_vel_scans;
             double loop_required_time;
             double loop_required_distance;
+            double loop_closure_spacing;
+            unsigned loop_descriptor_top_k;
+            double loop_descriptor_search_distance;
+            double loop_descriptor_max_distance;
+            bool use_vgicp;
+            double vgicp_resolution;
+            unsigned vgicp_threads;
+
+            // register the velodyne edges in x, y and yaw only, the roll and pitch from the ground planes
+            bool use_planar_velodyne_odometry;
+            bool use_planar_velodyne_loop;
+            bool use_ground_leveling;
+
+            // the coarse registration levels, before the full resolution one
+            std::vector<RegistrationLevel> registration_pyramid;
             unsigned icp_threads_pool_size;
             unsigned icp_thread_block_size;
+            double icp_thread_block_distance;
             double lidar_odometry_min_distance;
+            double lidar_keyframe_distance;
+            double lidar_keyframe_yaw;
+            double lidar_keyframe_min_overlap;
+            unsigned lidar_keyframe_max_step;
+            double local_map_radius;
             double visual_odometry_min_distance;
             double icp_translation_confidence_factor;
             bool save_accumulated_point_clouds;
@@ -121,42 +221,43 @@ namespace hyper {
 
             bool use_fake_gps;
 
+            bool use_mmap_log_reader;
+            unsigned log_parser_threads;
+            unsigned velodyne_decoder_threads;
+            unsigned velodyne_decoder_queue_size;
+            unsigned cloud_writer_queue_size;
+            bool cloud_writer_compressed;
+            bool cloud_writer_drop_when_full;
+            unsigned cloud_cache_mb;
+            std::string scratch_root;
+            bool use_in_memory_scratch;
+
+            // build a new message based on the log tag, it returns nullptr for the discarded tags
+            StampedMessagePtr CreateMessageFromTag(const LogLine &tag);
+
+            // destroy a single message, its memory is released with the pool
+            void DestroyMessage(StampedMessagePtr msg);
+
+            // parse a single log line, it returns nullptr for the discarded and invalid lines
+            StampedMessagePtr ParseLogLine(const LogLine &line, unsigned &vldn_msgs);
+
+            // parse a newline aligned byte range of the mapped log file, used by the parser threads
+            void ParseLogRange(const MappedLogFile *logfile, std::size_t first, std::size_t last, unsigned vel_scans, StampedMessagePtrVector *output);
+
+            // keep the first vel_scans velodyne messages and assign the sequential message ids
+            void FinishParsedMessages(unsigned vel_scans);
+
             // separate the gps, sick and velodyne messages
             void SeparateMessages();
 
             // get the gps antena position in relation to sensor board
             void SetGPSPose(std::string carmen_home);
 
-            // get the gps estimation
-            g2o::SE2 GetNearestGPSMeasure(
-                        StampedMessagePtrVector::iterator it,
-                        StampedMessagePtrVector::iterator end,
-                        int adv,
-                        double timestamp,
-                        double &dt);
-
-            // get the gps estimation
-            g2o::SE2 GetGPSMeasure(
-                        StampedMessagePtrVector::iterator begin,
-                        StampedMessagePtrVector::iterator gps,
-                        StampedMessagePtrVector::iterator end,
-                        double timestamp);
-
-            // get the gps estimation
-            void GetNearestOrientation(
-                        StampedMessagePtrVector::iterator it,
-                        StampedMessagePtrVector::iterator end,
-                        int adv,
-                        double timestamp,
-                        double &h,
-                        double &dt);
-
-            // get the gps full measure
-            Eigen::Rotation2Dd GetGPSOrientation(
-                        StampedMessagePtrVector::iterator begin,
-                        StampedMessagePtrVector::iterator it,
-                        StampedMessagePtrVector::iterator end,
-                        double timestamp);
+            // get the nearest gps measure in time
+            g2o::SE2 GetGPSMeasure(double timestamp);
+
+            // get the nearest gps orientation in time
+            Eigen::Rotation2Dd GetGPSOrientation(double timestamp);
 
             // get the first gps position
             Eigen::Vector2d GetFirstGPSPosition();
@@ -176,32 +277,101 @@ namespace hyper {
             // build the initial estimates
             void BuildOdometryEstimates(bool gps_based);
 
-            // build an icp measure
+            // build an icp measure, the next cloud is registered against the local map and inserted on success
             bool BuildLidarOdometryMeasure(
                     GeneralizedICP &gicp,
-                    VoxelGridFilter &grid_filtering,
+                    VoxelizedGICP &vgicp,
                     double cf,
                     const g2o::SE2 &odom,
-                    PointCloudHSV::Ptr source_cloud,
-                    PointCloudHSV::Ptr target_cloud,
+                    LocalVoxelMap &local_map,
+                    StampedLidarPtr target,
+                    PointCloudHSV::ConstPtr target_cloud,
+                    CloudFeatures::ConstPtr target_features,
                     g2o::SE2 &icp_measure);
 
             // build an icp measure
             bool BuildLidarLoopMeasure(
                     GeneralizedICP &gicp,
+                    VoxelizedGICP &vgicp,
                     double cf,
-                    PointCloudHSV::Ptr source_cloud,
-                    PointCloudHSV::Ptr target_cloud,
-                    g2o::SE2 &loop_measure);
-
-            // get the next lidar block
-            bool GetNextLidarBlock(unsigned &first_index, unsigned &last_index);
+                    StampedLidarPtr source,
+                    StampedLidarPtr target,
+                    PointCloudHSV::ConstPtr source_cloud,
+                    PointCloudHSV::ConstPtr target_cloud,
+                    CloudFeatures::ConstPtr source_features,
+                    CloudFeatures::ConstPtr target_features,
+                    const g2o::SE2 &guess,
+                    g2o::SE2 &loop_measure,
+                    double &fitness);
+
+            // a single registration level
+            bool AlignLevel(
+                    GeneralizedICP &gicp,
+                    VoxelizedGICP &vgicp,
+                    double cf,
+                    unsigned max_iterations,
+                    PointCloudHSV::ConstPtr source_cloud,
+                    CloudFeatures::ConstPtr source_features,
+                    PointCloudHSV::ConstPtr target_cloud,
+                    CloudFeatures::ConstPtr target_features,
+                    const Eigen::Matrix4f &guess,
+                    Eigen::Matrix4f &transformation,
+                    double &fitness);
+
+            // align the source cloud to the target cloud with the selected registration method
+            // the coarse levels run first, each one seeds the next
+            // the source features are required, the target ones are computed when they are missing
+            // the coarse levels of the clouds with a lidar message are cached, the local map has none
+            bool AlignClouds(
+                    GeneralizedICP &gicp,
+                    VoxelizedGICP &vgicp,
+                    double cf,
+                    StampedLidarPtr source,
+                    PointCloudHSV::ConstPtr source_cloud,
+                    CloudFeatures::ConstPtr source_features,
+                    StampedLidarPtr target,
+                    PointCloudHSV::ConstPtr target_cloud,
+                    CloudFeatures::ConstPtr target_features,
+                    const Eigen::Matrix4f &guess,
+                    Eigen::Matrix4f &transformation,
+                    double &fitness);
+
+            // get a downsampled cloud and its features, from the cache when the lidar message isn't null
+            // the coarse cloud is null if it can't be built, the features are null if it's too small or not requested
+            void GetCoarseCloud(
+                    StampedLidarPtr lidar,
+                    PointCloudHSV::ConstPtr cloud,
+                    double leaf,
+                    bool with_features,
+                    PointCloudHSV::ConstPtr &coarse,
+                    CloudFeatures::ConstPtr &coarse_features);
+
+            // get the lidar cloud from the cache, it returns a null pointer if the cloud can't be loaded
+            PointCloudHSV::ConstPtr GetCachedCloud(StampedLidarPtr lidar);
+
+            // get the registration features of a cached cloud, it returns a null pointer if the cloud is too small
+            CloudFeatures::ConstPtr GetCachedFeatures(StampedLidarPtr lidar, PointCloudHSV::ConstPtr cloud);
+
+            // get the next lidar block of a given icp thread
+            bool GetNextLidarBlock(unsigned worker, unsigned &first_index, unsigned &last_index);
+
+            // the next lidar keyframe, after enough displacement or yaw change, or before the overlap gets too small
+            unsigned GetNextKeyframe(const StampedLidarPtrVector &lidar_messages, unsigned current_index, unsigned last_index);
+
+            // split the lidar messages in blocks, limited by the message count and the traveled distance
+            void BuildLidarBlocks(const StampedLidarPtrVector &lidar_messages, std::vector<BlockScheduler::Block> &blocks);
 
             // it results in a safe region
             bool GetNextICPIterators(StampedLidarPtrVector::iterator &begin, StampedLidarPtrVector::iterator &end);
 
             // the main icp measure method, multithreading version
-            void BuildLidarMeasuresMT();
+            void BuildLidarMeasuresMT(unsigned worker);
+
+            // get the next loop closure candidate
+            bool GetNextLoopCandidate(unsigned size, unsigned &index);
+
+            // register the loop closure candidates, multithreading version
+            void BuildLidarLoopMeasuresMT(const StampedLidarPtrVector *lidar_messages, std::vector<LidarLoopCandidate> *candidates);
 
             // build sequential and loop restriction ICP measures
             void BuildLidarOdometryMeasuresWithThreads(StampedLidarPtrVector &lidar_messages);
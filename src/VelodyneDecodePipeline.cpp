@@ -0,0 +1,99 @@
+#include <VelodyneDecodePipeline.hpp>
+
+#include <algorithm>
+
+using namespace hyper;
+
+// the basic constructor
+VelodyneDecodePipeline::VelodyneDecodePipeline() : queue(VELODYNE_DECODER_QUEUE_SIZE), workers(0), failed(0), error(nullptr), failed_mutex() {}
+
+// the basic destructor
+VelodyneDecodePipeline::~VelodyneDecodePipeline()
+{
+    Stop();
+}
+
+// the decoder thread loop
+void VelodyneDecodePipeline::Decode()
+{
+    // the segmentation class
+    SimpleLidarSegmentation segm;
+
+    // the current scan
+    StampedVelodynePtr velodyne = nullptr;
+
+    while (queue.Pop(velodyne))
+    {
+        bool decoded = false;
+
+        try
+        {
+            decoded = velodyne->DecodeScan(segm);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(failed_mutex);
+
+            if (nullptr == error)
+            {
+                error = std::current_exception();
+            }
+        }
+
+        if (!decoded)
+        {
+            std::lock_guard<std::mutex> lock(failed_mutex);
+
+            failed.push_back(velodyne);
+        }
+    }
+}
+
+// start the decoder threads
+void VelodyneDecodePipeline::Start(unsigned threads, unsigned queue_size)
+{
+    // an aborted parse may have left the old decoders running
+    Stop();
+
+    queue.Reset(queue_size);
+    failed.clear();
+    error = nullptr;
+
+    for (unsigned i = 0; i < std::max(1u, threads); ++i)
+    {
+        workers.push_back(std::thread(&VelodyneDecodePipeline::Decode, this));
+    }
+}
+
+// push a tokenized scan
+void VelodyneDecodePipeline::Push(StampedVelodynePtr velodyne)
+{
+    queue.Push(velodyne);
+}
+
+// close the queue and join the decoder threads
+void VelodyneDecodePipeline::Stop()
+{
+    queue.Close();
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    workers.clear();
+}
+
+// wait all the queued scans
+std::vector<StampedVelodynePtr> VelodyneDecodePipeline::Finish()
+{
+    // the decoders quit after the last scan
+    Stop();
+
+    if (nullptr != error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    return failed;
+}
@@ -0,0 +1,72 @@
+#ifndef HYPERGRAPHSLAM_VELODYNE_DECODE_PIPELINE_HPP
+#define HYPERGRAPHSLAM_VELODYNE_DECODE_PIPELINE_HPP
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <exception>
+
+#include <StampedVelodyne.hpp>
+#include <BoundedQueue.hpp>
+
+namespace hyper {
+
+#define VELODYNE_DECODER_THREADS 4
+#define VELODYNE_DECODER_QUEUE_SIZE 64
+
+    // the log parser only tokenizes the velodyne messages and pushes them here
+    // a pool of decoder threads reads, segments and saves the scans
+    class VelodyneDecodePipeline
+    {
+        private:
+
+            // the tokenized scans
+            BoundedQueue<StampedVelodynePtr> queue;
+
+            // the decoder threads
+            std::vector<std::thread> workers;
+
+            // the scans that could not be decoded
+            std::vector<StampedVelodynePtr> failed;
+
+            // the first exception thrown by a decoder thread
+            std::exception_ptr error;
+
+            // protects the failed list and the error
+            std::mutex failed_mutex;
+
+            // the decoder thread loop, with its own segmentation object
+            void Decode();
+
+            // removing the copy constructor
+            VelodyneDecodePipeline(const VelodyneDecodePipeline&) = delete;
+
+            // removing the assignment operator overloading
+            void operator=(const VelodyneDecodePipeline&) = delete;
+
+        public:
+
+            // the basic constructor
+            VelodyneDecodePipeline();
+
+            // the basic destructor
+            ~VelodyneDecodePipeline();
+
+            // start the decoder threads, at most queue_size scans wait in the queue
+            void Start(unsigned threads, unsigned queue_size);
+
+            // push a tokenized scan, it blocks while the queue is full
+            void Push(StampedVelodynePtr velodyne);
+
+            // close the queue and join the decoder threads, it never throws
+            // the scans live in the message pools, so it must run before the pools are released
+            void Stop();
+
+            // wait all the queued scans, it rethrows the first decoder exception
+            // returns the scans that could not be decoded
+            std::vector<StampedVelodynePtr> Finish();
+    };
+
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <cstdlib>
+
+#include <CloudCache.hpp>
+#include <PackedCloudStore.hpp>
+
+using namespace hyper;
+
+// how many points in each test cloud
+#define TEST_CLOUD_POINTS 500
+
+// how many clouds, enough to exceed the budget many times
+#define TEST_CLOUDS 64
+
+// fill a small grid cloud, each slot gets a different offset
+static bool LoadTestCloud(std::size_t slot, PointCloudHSV &cloud)
+{
+    cloud.clear();
+
+    for (unsigned i = 0; i < TEST_CLOUD_POINTS; ++i)
+    {
+        pcl::PointXYZHSV p;
+
+        p.x = float(slot) + 0.1f * float(i % 25);
+        p.y = 0.1f * float(i / 25);
+        p.z = 0.01f * float(i % 7);
+        p.h = p.s = p.v = 0.0f;
+
+        cloud.push_back(p);
+    }
+
+    return true;
+}
+
+
+int
+main()
+{
+    PackedCloudStore store;
+    CloudCache cache;
+
+    // 1 MB, a few clouds with their features
+    cache.SetBudget(1);
+
+    for (std::size_t slot = 0; slot < TEST_CLOUDS; ++slot)
+    {
+        // the handle and the features are released at the end of each iteration, like the icp workers do
+        PointCloudHSV::ConstPtr cloud(cache.Get(store, slot, [slot](PointCloudHSV &c) { return LoadTestCloud(slot, c); }));
+
+        if (nullptr == cloud || nullptr == cache.GetFeatures(store, slot, cloud))
+        {
+            std::cerr << "FAIL: could not load the cloud " << slot << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // the search trees keep the clouds, but they must not pin them
+    if ((std::size_t(1) << 20) < cache.Used())
+    {
+        std::cerr << "FAIL: " << cache.Used() << " bytes used with a 1 MB budget" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the first cloud was evicted, so it's loaded again
+    std::size_t hits, misses;
+
+    cache.Get(store, 0, [](PointCloudHSV &c) { return LoadTestCloud(0, c); });
+    cache.Statistics(hits, misses);
+
+    if (TEST_CLOUDS + 1 != misses)
+    {
+        std::cerr << "FAIL: the first cloud was not evicted" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // a live handle still pins its cloud
+    PointCloudHSV::ConstPtr pinned(cache.Get(store, TEST_CLOUDS, [](PointCloudHSV &c) { return LoadTestCloud(TEST_CLOUDS, c); }));
+    cache.GetFeatures(store, TEST_CLOUDS, pinned);
+
+    for (std::size_t slot = 0; slot < TEST_CLOUDS; ++slot)
+    {
+        cache.Get(store, slot, [slot](PointCloudHSV &c) { return LoadTestCloud(slot, c); });
+    }
+
+    // the pinned cloud must be a hit
+    std::size_t pinned_hits;
+
+    cache.Statistics(hits, misses);
+    cache.Get(store, TEST_CLOUDS, [](PointCloudHSV &c) { return LoadTestCloud(TEST_CLOUDS, c); });
+    cache.Statistics(pinned_hits, misses);
+
+    if (hits + 1 != pinned_hits)
+    {
+        std::cerr << "FAIL: the pinned cloud was evicted" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the downsampled levels are built once while the cloud is cached
+    unsigned downsampled = 0;
+
+    CloudCache::CloudLoader downsampler([&pinned, &downsampled](PointCloudHSV &coarse)
+    {
+        ++downsampled;
+
+        for (std::size_t i = 0; i < pinned->size(); i += 4)
+        {
+            coarse.push_back(pinned->points[i]);
+        }
+
+        return true;
+    });
+
+    PointCloudHSV::ConstPtr first_level, second_level;
+    CloudFeatures::ConstPtr first_features, second_features;
+
+    if (!cache.GetLevel(store, TEST_CLOUDS, pinned, 0.5, downsampler, first_level, first_features) ||
+        !cache.GetLevel(store, TEST_CLOUDS, pinned, 0.5, downsampler, second_level, second_features))
+    {
+        std::cerr << "FAIL: could not build the downsampled level" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (1 != downsampled || first_level != second_level || nullptr == first_features || first_features != second_features)
+    {
+        std::cerr << "FAIL: the downsampled level was built " << downsampled << " times" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "CloudCache eviction: OK" << std::endl;
+
+    return EXIT_SUCCESS;
+}